@@ -0,0 +1,181 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+// Chunked bump allocator for search-tree nodes. Memory is carved out of
+// fixed-size chunks; a Region collects the chunks it has used and gives them
+// all back at once, so a whole tree is released by splicing one list rather
+// than by visiting its nodes. Released chunks stay in the arena for reuse
+// until it is destroyed, and the arena never holds more than its budget.
+//
+// Allocation goes through a Cursor, one per thread: it bumps a pointer
+// inside its current chunk and only takes the arena lock to fetch the next.
+// Nothing is ever destroyed, so T must be trivially destructible.
+template <typename T>
+class Arena {
+    struct Chunk;
+
+public:
+    static constexpr int CHUNK_ITEMS = 4096;
+    static constexpr size_t CHUNK_BYTES = CHUNK_ITEMS * sizeof(T);
+
+    // Chunks in use by one tree
+    class Region {
+    public:
+        explicit Region(Arena& arena) : arena(arena) {}
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+        ~Region() { release(); }
+
+        // Hands every chunk back to the arena; anything allocated here is gone
+        void release();
+        size_t chunkCount() const { return chunks; }
+
+    private:
+        friend class Arena;
+        Arena& arena;
+        Chunk* head = nullptr;
+        Chunk* tail = nullptr;
+        size_t chunks = 0;
+    };
+
+    class Cursor {
+    public:
+        explicit Cursor(Region& region) : region(&region) {}
+
+        // count default-constructed items in a row, or nullptr once the
+        // arena budget is spent
+        T* allocate(int count);
+
+    private:
+        Region* region;
+        T* next = nullptr;
+        T* end = nullptr;
+    };
+
+    // budgetBytes of 0 means no limit
+    explicit Arena(size_t budgetBytes = 0) : budgetBytes(budgetBytes) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void setBudget(size_t bytes);
+    size_t budget() const { return budgetBytes; }
+    size_t bytesReserved() const { return totalChunks * CHUNK_BYTES; }
+    size_t bytesInUse() const { return (totalChunks - freeChunks) * CHUNK_BYTES; }
+
+private:
+    struct Chunk {
+        alignas(T) unsigned char storage[CHUNK_BYTES];
+        Chunk* next;
+    };
+
+    static_assert(std::is_trivially_destructible_v<T>, "arena items are never destroyed");
+
+    std::mutex mutex;
+    Chunk* freeList = nullptr;
+    size_t freeChunks = 0;
+    size_t totalChunks = 0;
+    size_t budgetBytes;
+    std::atomic<bool> exhausted{false}; // lets cursors fail without taking the lock
+
+    Chunk* takeChunk(Region& region);
+};
+
+template <typename T>
+Arena<T>::~Arena() {
+    assert(freeChunks == totalChunks && "a Region outlived its Arena");
+    while (freeList) {
+        Chunk* chunk = freeList;
+        freeList = chunk->next;
+        delete chunk;
+    }
+}
+
+template <typename T>
+void Arena<T>::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budgetBytes = bytes;
+    while (freeList && budgetBytes != 0 && totalChunks * CHUNK_BYTES > budgetBytes) {
+        Chunk* chunk = freeList;
+        freeList = chunk->next;
+        delete chunk;
+        freeChunks--;
+        totalChunks--;
+    }
+    exhausted.store(false, std::memory_order_relaxed);
+}
+
+template <typename T>
+typename Arena<T>::Chunk* Arena<T>::takeChunk(Region& region) {
+    if (exhausted.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Chunk* chunk = freeList;
+    if (chunk) {
+        freeList = chunk->next;
+        freeChunks--;
+    } else if (budgetBytes == 0 || (totalChunks + 1) * CHUNK_BYTES <= budgetBytes) {
+        chunk = new Chunk;
+        totalChunks++;
+    } else {
+        exhausted.store(true, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    chunk->next = nullptr;
+    if (region.tail) {
+        region.tail->next = chunk;
+    } else {
+        region.head = chunk;
+    }
+    region.tail = chunk;
+    region.chunks++;
+    return chunk;
+}
+
+template <typename T>
+void Arena<T>::Region::release() {
+    if (!head) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    tail->next = arena.freeList;
+    arena.freeList = head;
+    arena.freeChunks += chunks;
+    arena.exhausted.store(false, std::memory_order_relaxed);
+    head = tail = nullptr;
+    chunks = 0;
+}
+
+template <typename T>
+T* Arena<T>::Cursor::allocate(int count) {
+    assert(count > 0 && count <= CHUNK_ITEMS);
+    if (end - next < count) {
+        // The tail of the old chunk is abandoned; it is at most one child list
+        Chunk* chunk = region->arena.takeChunk(*region);
+        if (!chunk) {
+            return nullptr;
+        }
+        next = reinterpret_cast<T*>(chunk->storage);
+        end = next + CHUNK_ITEMS;
+    }
+
+    T* items = next;
+    for (int i = 0; i < count; ++i) {
+        new (items + i) T();
+    }
+    next += count;
+    return items;
+}
+
+#endif // ARENA_HPP
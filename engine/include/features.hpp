@@ -0,0 +1,55 @@
+#ifndef FEATURES_HPP
+#define FEATURES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "go_engine.hpp"
+
+// Input planes for a neural network, each size x size, from the side of the
+// player to move. Every plane is 0 or 1.
+enum FeaturePlane {
+    OWN_STONES,
+    OPPONENT_STONES,
+    LIBERTIES_1,        // stones of either color whose chain has 1 liberty
+    LIBERTIES_2,
+    LIBERTIES_3,
+    LIBERTIES_4_PLUS,
+    KO_POINT,           // the point the player to move may not retake
+    LEGAL_MOVES,        // for the player to move
+    HISTORY_PLANES,     // the last move, then the one before, up to history; a pass leaves its plane empty
+};
+
+enum TensorLayout {
+    NCHW,   // plane by plane
+    NHWC,   // point by point, every plane of a point together
+};
+
+struct FeatureSpec {
+    int history = MOVE_HISTORY;     // recent-move planes, at most MOVE_HISTORY
+    TensorLayout layout = NCHW;
+
+    int planeCount() const { return HISTORY_PLANES + history; }
+    // Elements one position fills
+    size_t tensorSize(int boardSize) const { return size_t(planeCount()) * boardSize * boardSize; }
+};
+
+// Writes every plane of position into out, which holds spec.tensorSize()
+// elements. Nothing is allocated.
+void extractFeatures(const GoEngine& position, const FeatureSpec& spec, float* out);
+void extractFeatures(const GoEngine& position, const FeatureSpec& spec, uint8_t* out);
+
+// Fills one tensor per position, one after another, split over threads
+// (0 uses every hardware thread). The positions must share a board size.
+void extractFeatures(std::span<const GoEngine* const> positions, const FeatureSpec& spec, float* out,
+                     int threads = 0);
+void extractFeatures(std::span<const GoEngine* const> positions, const FeatureSpec& spec, uint8_t* out,
+                     int threads = 0);
+
+// Turns or mirrors every plane of one tensor written with spec, as if the
+// position had been transformed by s first. in and out must not overlap.
+void transformFeatures(const FeatureSpec& spec, int boardSize, Symmetry s, const float* in, float* out);
+void transformFeatures(const FeatureSpec& spec, int boardSize, Symmetry s, const uint8_t* in, uint8_t* out);
+
+#endif // FEATURES_HPP
@@ -0,0 +1,110 @@
+#ifndef GAME_RECORD_HPP
+#define GAME_RECORD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "go_engine.hpp"
+#include "sgf.hpp"
+
+// Binary container for game records, about a tenth the size of SGF and
+// readable without parsing. All fields are little-endian.
+//
+//   file header   "GOGR", version, game count, index offset      24 bytes
+//   games         one after another, each 2-byte aligned
+//   index         one 8-byte file offset per game, 8-byte aligned
+//
+// Each game is a 16-byte header (size, result, komi, counts) followed by
+// its setup stones and then its moves at 2 bytes apiece: the point y*size+x
+// in the low 12 bits, a pass flag and a colour flag.
+
+struct GameResult {
+    enum Reason : uint8_t { UNKNOWN, SCORE, RESIGN, TIME, FORFEIT, DRAW, VOID };
+
+    Stone winner = EMPTY;   // EMPTY for draws and unknown results
+    Reason reason = UNKNOWN;
+    double margin = 0;      // points, for SCORE; kept to the nearest half
+
+    bool operator==(const GameResult&) const = default;
+};
+
+// Reads an SGF RE value such as "B+R", "W+3.5", "0" or "Void"
+GameResult parseResult(std::string_view text);
+std::string toString(const GameResult& result);
+
+// One game inside a mapped file; valid while its reader is
+class GameRecord {
+public:
+    int size = 0;
+    double komi = 0;
+    GameResult result;
+
+    int getSetupCount() const { return setupCount; }
+    int getMoveCount() const { return moveCount; }
+    SgfMove getSetup(int i) const { return decode(setupData[i]); }
+    SgfMove getMove(int i) const { return decode(moveData[i]); }
+
+private:
+    friend class GameRecordReader;
+
+    const uint16_t* setupData = nullptr;
+    const uint16_t* moveData = nullptr;
+    int setupCount = 0;
+    int moveCount = 0;
+
+    SgfMove decode(uint16_t code) const;
+};
+
+// Appends games to a new file; the index is written by close(), which the
+// destructor calls if needed. Throws std::runtime_error on I/O errors.
+class GameRecordWriter {
+public:
+    explicit GameRecordWriter(const std::string& path);
+    ~GameRecordWriter();
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    void add(const SgfGame& game);
+    void close();
+
+    size_t getGameCount() const { return offsets.size(); }
+
+private:
+    std::FILE* file = nullptr;
+    std::string path;
+    uint64_t offset = 0;
+    std::vector<uint64_t> offsets;
+    std::vector<uint16_t> buffer;
+
+    void write(const void* data, size_t bytes);
+};
+
+// Random access to the games of a mapped file. Throws std::runtime_error
+// when the file is not a game-record file or a record runs past its end.
+class GameRecordReader {
+public:
+    explicit GameRecordReader(const std::string& path);
+
+    size_t getGameCount() const { return gameCount; }
+    GameRecord getGame(size_t index) const;
+
+private:
+    MappedFile file;
+    const uint64_t* index = nullptr;
+    size_t gameCount = 0;
+};
+
+// Appends every game of an SGF collection to writer; returns how many.
+// Throws SgfError for malformed text, leaving the games before it written.
+size_t convertSgf(std::string_view text, GameRecordWriter& writer);
+
+// Same rules as replaying the SGF the record was converted from
+ReplayReport replay(const GameRecord& game, GoEngine& engine,
+                    const std::function<void(const GoEngine&, const SgfMove&)>& onMove = nullptr);
+
+#endif // GAME_RECORD_HPP
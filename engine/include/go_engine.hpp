@@ -1,12 +1,271 @@
 #ifndef GO_ENGINE_HPP
 #define GO_ENGINE_HPP
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <unordered_set> // Include this header
 #include <utility>       // For std::pair
 #include <string>
+#include <variant>
 
-enum Stone { EMPTY, BLACK, WHITE };
+// OFFBOARD only ever appears in the sentinel ring around the playable area
+enum Stone : uint8_t { EMPTY, BLACK, WHITE, OFFBOARD };
+
+// Largest board SGF can describe
+constexpr int MAX_BOARD_SIZE = 52;
+constexpr int MAX_POINTS = (MAX_BOARD_SIZE + 2) * (MAX_BOARD_SIZE + 2);
+
+// Largest of the usual sizes; run-time sized engines up to it stay compact
+constexpr int MAX_STANDARD_SIZE = 19;
+
+// 64-bit words needed for the padded form of a size x size board
+constexpr int bitboardWords(int size) {
+    return ((size + 2) * (size + 2) + 63) / 64;
+}
+
+// Bitboard::dilate for any word count; words and out hold count words
+void dilateWords(const uint64_t* words, uint64_t* out, int count, int stride);
+constexpr int PASS = 0; // point 0 is always OFFBOARD, so it stands for a pass in move lists
+
+// Moves, passes included, each engine remembers for getRecentMove
+constexpr int MOVE_HISTORY = 8;
+
+// SIMPLE_KO only forbids retaking a single-stone ko at once; the superko rules
+// forbid any move that recreates an earlier position (positional) or an earlier
+// position with the same player to move (situational)
+enum KoRule { SIMPLE_KO, POSITIONAL_SUPERKO, SITUATIONAL_SUPERKO };
+
+// The 8 rotations and reflections of the board. Rotations are clockwise as
+// printed, with y growing downwards; FLIP_X mirrors left and right.
+enum Symmetry { IDENTITY, ROTATE_90, ROTATE_180, ROTATE_270, FLIP_X, FLIP_Y, TRANSPOSE, ANTI_TRANSPOSE };
+constexpr int SYMMETRIES = 8;
+
+constexpr Symmetry inverse(Symmetry s) {
+    return s == ROTATE_90 ? ROTATE_270 : s == ROTATE_270 ? ROTATE_90 : s;
+}
+
+// Where s takes (x, y) on a size x size board
+constexpr std::pair<int, int> transformCoordinates(Symmetry s, int x, int y, int size) {
+    int last = size - 1;
+    switch (s) {
+    case ROTATE_90: return {last - y, x};
+    case ROTATE_180: return {last - x, last - y};
+    case ROTATE_270: return {y, last - x};
+    case FLIP_X: return {last - x, y};
+    case FLIP_Y: return {x, last - y};
+    case TRANSPOSE: return {y, x};
+    case ANTI_TRANSPOSE: return {last - y, last - x};
+    default: return {x, y};
+    }
+}
+
+// One bit per point of a padded board, indexed like GoEngine's own board so a
+// shift by 1 or by the stride moves every bit to a neighboring point. Each
+// engine uses the fewest words its board needs; Bitboard covers every size,
+// and smaller ones widen to it implicitly.
+template <int W>
+class BasicBitboard {
+public:
+    static constexpr int WORDS = W;
+
+    BasicBitboard() = default;
+
+    template <int OTHER>
+        requires(OTHER < W)
+    BasicBitboard(const BasicBitboard<OTHER>& other) {
+        for (int i = 0; i < OTHER; ++i) {
+            words[i] = other.words[i];
+        }
+    }
+
+    bool test(int point) const { return (words[point >> 6] >> (point & 63)) & 1; }
+    void set(int point) { words[point >> 6] |= uint64_t(1) << (point & 63); }
+    void reset(int point) { words[point >> 6] &= ~(uint64_t(1) << (point & 63)); }
+
+    int count() const {
+        int total = 0;
+        for (uint64_t word : words) {
+            total += __builtin_popcountll(word);
+        }
+        return total;
+    }
+
+    bool empty() const {
+        uint64_t any = 0;
+        for (uint64_t word : words) {
+            any |= word;
+        }
+        return any == 0;
+    }
+
+    // This set plus the four neighbors of every point in it
+    BasicBitboard dilate(int stride) const {
+        BasicBitboard result;
+        dilateWords(words.data(), result.words.data(), WORDS, stride);
+        return result;
+    }
+
+    // The n-th set point counting from 0, n < count()
+    int nth(int n) const {
+        for (int i = 0; i < WORDS; ++i) {
+            int bits = __builtin_popcountll(words[i]);
+            if (n < bits) {
+                uint64_t word = words[i];
+                for (; n > 0; --n) {
+                    word &= word - 1;
+                }
+                return i * 64 + __builtin_ctzll(word);
+            }
+            n -= bits;
+        }
+        return -1;
+    }
+
+    // Calls f(point) for every set point, in increasing order
+    template <typename F>
+    void forEach(F f) const {
+        for (int i = 0; i < WORDS; ++i) {
+            for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+                f(i * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    BasicBitboard operator&(const BasicBitboard& other) const {
+        BasicBitboard result;
+        for (int i = 0; i < WORDS; ++i) {
+            result.words[i] = words[i] & other.words[i];
+        }
+        return result;
+    }
+
+    BasicBitboard operator|(const BasicBitboard& other) const {
+        BasicBitboard result;
+        for (int i = 0; i < WORDS; ++i) {
+            result.words[i] = words[i] | other.words[i];
+        }
+        return result;
+    }
+
+    BasicBitboard operator^(const BasicBitboard& other) const {
+        BasicBitboard result;
+        for (int i = 0; i < WORDS; ++i) {
+            result.words[i] = words[i] ^ other.words[i];
+        }
+        return result;
+    }
+
+    bool operator==(const BasicBitboard& other) const { return words == other.words; }
+    bool operator!=(const BasicBitboard& other) const { return words != other.words; }
+
+    std::array<uint64_t, WORDS> words{};
+};
+
+using Bitboard = BasicBitboard<bitboardWords(MAX_BOARD_SIZE)>;
+
+// Fixed-capacity list of board points, filled without touching the heap
+class MoveList {
+public:
+    static constexpr int CAPACITY = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+
+    void clear() { count = 0; }
+    void push_back(int point) { points[count++] = point; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](int i) const { return points[i]; }
+    const int* begin() const { return points.data(); }
+    const int* end() const { return points.data() + count; }
+
+private:
+    std::array<int, CAPACITY> points;
+    int count = 0;
+};
+
+// What one move changed, so a view of the board can follow it without
+// comparing whole boards. The captured stones come chain by chain, each
+// chain from its head.
+struct MoveDelta {
+    int point = PASS;       // where the stone went, PASS for a pass
+    Stone stone = EMPTY;    // who moved
+    int koPoint = 0;        // the point the next player may not take back, 0 if none
+    int chainCount = 0;     // captured chains, at most 4
+    int chainEnds[4] = {};  // chain i is captured[chainEnds[i - 1]] up to captured[chainEnds[i]], from 0
+    MoveList captured;
+
+    void clear() {
+        point = PASS;
+        stone = EMPTY;
+        koPoint = 0;
+        chainCount = 0;
+        captured.clear();
+    }
+};
+
+// Called by GoEngine after each move made with placeStone or passTurn
+using MoveObserver = std::function<void(const MoveDelta&)>;
+
+// Point permutations for the symmetries of one board size, built on first
+// use and shared by every engine of that size. Padded points are numbered as
+// in the engines; indices are y * size + x, as in feature planes.
+class SymmetryTable {
+public:
+    // Throws std::invalid_argument outside 1..MAX_BOARD_SIZE
+    static const SymmetryTable& forSize(int size);
+
+    int getBoardSize() const { return boardSize; }
+    // Off-board points, PASS among them, map to PASS
+    int transformPoint(Symmetry s, int point) const { return points[s * pointCount + point]; }
+    int transformIndex(Symmetry s, int index) const { return indices[s * boardSize * boardSize + index]; }
+    void transformMoves(Symmetry s, const MoveList& moves, MoveList& out) const;
+
+    // Zobrist key of stone at point after s, for every s at once; the EMPTY
+    // row holds the key of a ko at point
+    const uint64_t* symmetricKeys(int point, Stone stone) const { return &keys[(point * 3 + stone) * SYMMETRIES]; }
+
+private:
+    int boardSize;
+    int pointCount;
+    std::vector<int> points;        // [symmetry][padded point]
+    std::vector<int> indices;       // [symmetry][y * size + x]
+    std::vector<uint64_t> keys;     // [padded point][EMPTY, BLACK, WHITE][symmetry]
+
+    explicit SymmetryTable(int size);
+};
+
+// Numbering of 3x3 neighborhoods, one table per board size, built on first
+// use and shared by every engine of that size. A code is the neighbors' digits
+// in mixed radix: N, E, S, W in base 5 (empty, black, white, black in atari,
+// white in atari) and then NE, SE, SW, NW in base 3 (empty, black, white).
+// Off-board neighbors get no digit; instead each combination of off-board
+// sides starts its own range of codes, so every code is below CODES.
+class PatternTable {
+public:
+    static constexpr int CODES = 55496;
+    static constexpr int NEIGHBORS = 8;     // N, E, S, W, NE, SE, SW, NW
+
+    // Throws std::invalid_argument outside 1..MAX_BOARD_SIZE
+    static const PatternTable& forSize(int size);
+
+    // The code of point with every neighbor empty
+    uint16_t emptyCode(int point) const { return bases[point]; }
+    // What a digit of 1 for the neighbor in direction adds to point's code;
+    // 0 for off-board points and neighbors
+    uint16_t weight(int point, int direction) const { return weights[point * NEIGHBORS + direction]; }
+    // The same weights seen from the other side: what a stone at point adds
+    // to the code of its neighbor in direction, all 8 side by side
+    const uint16_t* spread(int point) const { return &spreads[point * NEIGHBORS]; }
+
+private:
+    std::vector<uint16_t> bases;    // [padded point]
+    std::vector<uint16_t> weights;  // [padded point][direction]
+    std::vector<uint16_t> spreads;  // [padded point][direction]
+
+    explicit PatternTable(int size);
+};
 
 // Hash function for std::pair<int, int>
 struct PairHash {
@@ -15,27 +274,425 @@ struct PairHash {
     }
 };
 
+// Multiset of position hashes in one open-addressing table with linear probing
+class PositionHistory {
+public:
+    PositionHistory();
+    void insert(uint64_t key);
+    void erase(uint64_t key);   // removes one occurrence
+    bool contains(uint64_t key) const;
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t count; // 0 marks a free slot
+    };
+
+    std::vector<Entry> slots; // power-of-two size, kept at most half full
+    size_t used;
+
+    size_t slotFor(uint64_t key) const;
+    void grow();
+};
+
+// Tromp-Taylor area count: every stone, plus every empty point whose region
+// reaches stones of one color only
+template <typename Bits>
+struct BasicAreaScore {
+    double score;           // black minus white, komi included
+    int black;              // points counted for each side
+    int white;
+    Bits blackArea;         // per-point ownership; neutral points are in neither
+    Bits whiteArea;
+
+    Stone ownerAt(int point) const { return blackArea.test(point) ? BLACK : whiteArea.test(point) ? WHITE : EMPTY; }
+};
+
+using AreaScore = BasicAreaScore<Bitboard>;
+
+// Who gets each point once play has stopped. Benson's algorithm settles
+// whatever it can prove: chains that cannot be captured even if their owner
+// passes every move, and the regions they enclose with no room for the other
+// side to live, whose stones are dead. Everything else is counted as by
+// Tromp-Taylor, with dead stones taken off first.
+//
+// Simple seki is two opposing chains with two liberties each, sharing at
+// least one, where a liberty that is not shared is an eye of the chain's own.
+// Neither side can fill a shared liberty without being captured, so those
+// liberties are neutral. A pair where a sacrifice would leave a killable eye
+// shape is still reported as seki.
+template <typename Bits>
+struct BasicOwnership {
+    Bits blackArea;         // stones and territory counted for each side
+    Bits whiteArea;
+    Bits passAlive;         // Benson-alive chains of either color and their pass-alive territory
+    Bits dead;              // stones inside the other side's pass-alive territory
+    Bits seki;              // chains in simple seki and the liberties they share
+
+    Stone ownerAt(int point) const { return blackArea.test(point) ? BLACK : whiteArea.test(point) ? WHITE : EMPTY; }
+};
+
+using Ownership = BasicOwnership<Bitboard>;
+
+// Board dimensions: compile-time constants for a fixed size N, members when
+// N is 0 and the size is only known at run time
+template <int N>
+struct BoardGeometry {
+    static constexpr int boardSize = N;
+    static constexpr int stride = N + 2;    // the width of a padded row
+
+    explicit BoardGeometry(int) {}
+};
+
+template <>
+struct BoardGeometry<0> {
+    int boardSize;
+    int stride;
+
+    explicit BoardGeometry(int size) : boardSize(size), stride(size + 2) {}
+};
+
+// Everything a BasicGoEngine<N, MAX_N> position is made of: stones, chains,
+// hash, ko point and whose turn it is, in one trivially copyable block. The
+// engine keeps it as a base, so snapshot() is a reference to it and copying
+// one is a single memcpy. Stones take a byte and points and chain counts two,
+// which keeps it to about 1.5 KB on 9x9 and 5 KB on 19x19.
+template <int N, int MAX_N>
+struct PositionState {
+    static constexpr int POINTS = (MAX_N + 2) * (MAX_N + 2);
+    static_assert(POINTS <= INT16_MAX, "points must fit in int16_t");
+    using Bits = BasicBitboard<bitboardWords(MAX_N)>;
+
+    // Every stone belongs to exactly one chain; its record lives at the head point
+    struct Chain {
+        int16_t size;
+        int16_t liberties;
+    };
+
+    int size;                           // of the board, so restore() can refuse another one
+    Stone lastPlayer;
+    std::array<Stone, POINTS> board;    // stride * stride points, border ring is OFFBOARD
+    Bits stoneBits[3];                  // points holding EMPTY, BLACK and WHITE
+    int koPoint;                        // point the next player may not take back, 0 if none
+    std::array<int, MOVE_HISTORY> recentMoves;  // ring of the last moves, indexed by moveNumber
+    int moveNumber;                     // moves and passes so far
+    uint64_t hash;
+    std::array<int16_t, POINTS> chainHead;  // head point of the chain at each stone, 0 elsewhere
+    std::array<int16_t, POINTS> nextStone;  // circular list linking the stones of each chain
+    std::array<Chain, POINTS> chains;       // indexed by head point
+    std::array<uint16_t, POINTS> patterns;  // getPattern without the atari digits
+
+    int getBoardSize() const { return size; }
+    Stone getStoneAt(int x, int y) const { return board[(y + 1) * (size + 2) + (x + 1)]; }
+    Stone getPlayerToMove() const { return lastPlayer == BLACK ? WHITE : BLACK; }
+    int getKoPoint() const { return koPoint; }
+    uint64_t getHash() const { return hash; }
+};
+
+// The engine for one board size. With N fixed, loop bounds, strides and
+// neighbor offsets are constants the compiler can unroll and fold, and the
+// board arrays and bitboards are no bigger than that size needs.
+// BasicGoEngine<0> takes any size up to MAX_N at run time, by default the
+// standard sizes; BasicGoEngine<0, MAX_BOARD_SIZE> takes every size.
+template <int N, int MAX_N = (N == 0 ? MAX_STANDARD_SIZE : N)>
+class BasicGoEngine : private BoardGeometry<N>, private PositionState<N, MAX_N> {
+public:
+    static_assert(N >= 0 && MAX_N <= MAX_BOARD_SIZE && (N == 0 || N == MAX_N), "unsupported board size");
+    static constexpr int FIXED_SIZE = N;   // 0 when the size is chosen at run time
+    static constexpr int POINTS = (MAX_N + 2) * (MAX_N + 2);
+
+    using Bits = BasicBitboard<bitboardWords(MAX_N)>;
+    using AreaScore = BasicAreaScore<Bits>;
+    using Ownership = BasicOwnership<Bits>;
+    using Snapshot = PositionState<N, MAX_N>;
+    // Immutable, so readers can keep one while the engine plays on
+    using SharedSnapshot = std::shared_ptr<const Snapshot>;
+    static_assert(std::is_trivially_copyable_v<Snapshot>);
+
+    explicit BasicGoEngine(int size = N);
+    int getBoardSize() const;
+    Stone getStoneAt(int x, int y) const;
+    bool placeStone(int x, int y, Stone stone);
+    bool isValidMove(int x, int y, Stone stone) const;
+    Stone getPlayerToMove() const;  // BLACK until someone has moved
+
+    // Every legal point for stone (or the player to move); passing is always legal
+    void generateLegalMoves(MoveList& moves) const;
+    void generateLegalMoves(MoveList& moves, Stone stone) const;
+    Bits legalMask(Stone stone) const;
+
+    // Padded point indices, as stored in MoveList and bitboards
+    int getPoint(int x, int y) const { return toIndex(x, y); }
+    std::pair<int, int> getCoordinates(int point) const { return {point % stride - 1, point / stride - 1}; }
+    int getStride() const { return stride; }
+    Stone getStoneAt(int point) const { return board[point]; }
+    const Bits& getStones(Stone stone) const { return stoneBits[stone]; } // EMPTY, BLACK or WHITE
+    bool placeStone(int point, Stone stone);
+    // Also fills delta, if the move is legal; nothing is allocated
+    bool placeStone(int point, Stone stone, MoveDelta& delta);
+    int countLiberties(int point) const { return chains[chainHead[point]].liberties; } // 0 if empty
+    int getKoPoint() const { return koPoint; }  // 0 if none
+    // PatternTable code of the 3x3 neighborhood of an on-board point. Stone
+    // colors are kept up to date as stones come and go; atari is read from
+    // the up to 4 adjacent chains here.
+    uint16_t getPattern(int point) const;
+
+    // The point played ago moves back (0 for the last one), PASS for a pass,
+    // or -1 before the first move or past MOVE_HISTORY
+    int getRecentMove(int ago) const;
+
+    // An empty point surrounded by stone whose diagonals it controls well
+    // enough that filling it could only hurt stone
+    bool isTrueEye(int point, Stone stone) const;
+    int countLiberties(int x, int y, Stone stone) const;
+    Bits getGroup(int x, int y) const;      // stones of the chain at (x, y)
+    Bits getLiberties(int x, int y) const;  // exact liberty set of that chain
+    void passTurn(Stone stone);
+    AreaScore scoreArea(double komi) const;
+
+    // Benson-alive chains of stone and the territory they make pass-alive
+    Bits passAlive(Stone stone) const;
+    // Linear in the number of points; see BasicOwnership
+    Ownership finalOwnership() const;
+
+    // Make/unmake for search; moves and passes must be undone in reverse order
+    bool doMove(int x, int y, Stone stone);
+    void undoMove();
+    void doPass(Stone stone);
+    void undoPass();
+
+    uint64_t getHash() const;   // Zobrist hash of stones, player who moved last and ko point
+    void setKoRule(KoRule rule);
+
+    // The position turned or mirrored by s, with its ko point and recent
+    // moves carried over; nothing can be undone past it and superko history
+    // starts from it
+    BasicGoEngine transformed(Symmetry s) const;
+    // transformed(s).getHash(), without building the position
+    uint64_t getHash(Symmetry s) const;
+    // The smallest hash over all 8 symmetries, the same for every one of them
+    uint64_t canonicalHash() const;
+    KoRule getKoRule() const;
+    void printBoard(std::string title = "") const;
+
+    // The position as it stands; copy it to keep it
+    const Snapshot& snapshot() const { return *this; }
+    SharedSnapshot share() const { return std::make_shared<const Snapshot>(snapshot()); }
+    // Puts back a snapshot of this engine's board size, else throws
+    // std::invalid_argument. As with transformed(), nothing can be undone
+    // past it and superko history starts from it.
+    void restore(const Snapshot& snapshot);
+
+private:
+    using Chain = typename Snapshot::Chain;
+
+    // Two chains joined by a move, with their records from before the join
+    struct MergeRecord {
+        int survivor;
+        int absorbed;
+        Chain survivorBefore;
+        Chain absorbedBefore;
+    };
+
+    // Everything needed to take back one doMove or doPass
+    struct UndoRecord {
+        int point;                      // 0 for a pass
+        Stone lastPlayer;
+        int koPoint;
+        uint64_t hash;
+        int capturedBegin;              // offset of the captured chains in undoStones
+        int capturedChains;
+        int mergeCount;
+        MergeRecord merges[4];
+        int evictedMove;                // recentMoves entry the move overwrote
+    };
+
+    using BoardGeometry<N>::boardSize;
+    using BoardGeometry<N>::stride;
+    using Snapshot::lastPlayer;
+    using Snapshot::board;
+    using Snapshot::stoneBits;
+    using Snapshot::koPoint;
+    using Snapshot::recentMoves;
+    using Snapshot::moveNumber;
+    using Snapshot::hash;
+    using Snapshot::chainHead;
+    using Snapshot::nextStone;
+    using Snapshot::chains;
+    using Snapshot::patterns;
+
+    KoRule koRule;
+    PositionHistory history;    // superko keys of every position so far
+    std::array<unsigned, POINTS> marks;     // scratch marks for liberty de-duplication
+    const PatternTable* patternTable;
+    unsigned markGeneration;
+    std::vector<UndoRecord> undoStack;
+    std::vector<int> undoStones;    // per captured chain: its size, then its stones from the head
+
+    // Index of (x, y) in the padded board; neighbors are at +-1 and +-stride
+    int toIndex(int x, int y) const { return (y + 1) * stride + (x + 1); }
+
+    void play(int point, Stone stone, UndoRecord* undo, MoveDelta* delta = nullptr);
+    void addStone(int point, Stone stone, UndoRecord* undo);
+    void mergeChains(int first, int second, UndoRecord* undo);
+    void updatePatterns(int point, int digit); // digit added at point, negative when a stone goes
+    bool isLibertyOf(int point, int head) const;
+    bool isLegalPoint(int point, Stone stone) const;
+    int adjacentChains(int point, int heads[4]) const; // distinct chains next to a point
+    void benson(Stone stone, Bits& chains, Bits& territory) const;
+    bool inSimpleSeki(int head, int other) const;
+    int captureStones(int point, Stone stone, int& capturedPoint, UndoRecord* undo, MoveDelta* delta);
+    void restoreGroup(const int* stones, int size, Stone color);
+    void takeBackStone(int point);
+    int removeGroup(int head);
+    uint64_t stateKey() const;
+    uint64_t superkoKey(uint64_t stonesHash, Stone mover) const;
+    bool repeatsPosition(int point, Stone stone) const;
+    unsigned nextMark();
+};
+
+extern template class BasicGoEngine<0>;
+extern template class BasicGoEngine<0, MAX_BOARD_SIZE>;
+extern template class BasicGoEngine<9>;
+extern template class BasicGoEngine<13>;
+extern template class BasicGoEngine<19>;
+
+// Any board size behind one type: holds the specialized engine for 9x9,
+// 13x13 and 19x19, a run-time sized one for the other standard sizes and a
+// large one past those. Every call dispatches on the size, so hot loops
+// should call visit() once and work on the engine inside, which has the same
+// interface apart from sizing its bitboards to the board.
 class GoEngine {
+    // The large engine lives on the heap, so it does not set the size of
+    // every GoEngine. Copies are deep, and assignment reuses the allocation.
+    template <typename T>
+    class Boxed {
+    public:
+        explicit Boxed(T* value) : value(value) {}
+        Boxed(const Boxed& other) : value(std::make_unique<T>(*other.value)) {}
+        Boxed(Boxed&&) noexcept = default;
+        Boxed& operator=(const Boxed& other) {
+            if (value) {
+                *value = *other.value;
+            } else {
+                value = std::make_unique<T>(*other.value);
+            }
+            return *this;
+        }
+        Boxed& operator=(Boxed&&) noexcept = default;
+
+        T& operator*() { return *value; }
+        const T& operator*() const { return *value; }
+
+    private:
+        std::unique_ptr<T> value;
+    };
+
 public:
+    using LargeEngine = BasicGoEngine<0, MAX_BOARD_SIZE>;
+    using Variant = std::variant<BasicGoEngine<9>, BasicGoEngine<13>, BasicGoEngine<19>, BasicGoEngine<0>,
+                                 Boxed<LargeEngine>>;
+
     GoEngine(int size);
     int getBoardSize() const;
     Stone getStoneAt(int x, int y) const;
     bool placeStone(int x, int y, Stone stone);
     bool isValidMove(int x, int y, Stone stone) const;
+    Stone getPlayerToMove() const;
+
+    void generateLegalMoves(MoveList& moves) const;
+    void generateLegalMoves(MoveList& moves, Stone stone) const;
+    Bitboard legalMask(Stone stone) const;
+
+    int getPoint(int x, int y) const { return (y + 1) * stride + (x + 1); }
+    std::pair<int, int> getCoordinates(int point) const { return {point % stride - 1, point / stride - 1}; }
+    int getStride() const { return stride; }
+    Stone getStoneAt(int point) const;
+    Bitboard getStones(Stone stone) const;
+    bool placeStone(int point, Stone stone);
+    bool placeStone(int point, Stone stone, MoveDelta& delta);
+    int countLiberties(int point) const;
+    int getKoPoint() const;
+    uint16_t getPattern(int point) const;
+    int getRecentMove(int ago) const;
+
+    bool isTrueEye(int point, Stone stone) const;
     int countLiberties(int x, int y, Stone stone) const;
+    Bitboard getGroup(int x, int y) const;
+    Bitboard getLiberties(int x, int y) const;
     void passTurn(Stone stone);
+    AreaScore scoreArea(double komi) const;
+    Bitboard passAlive(Stone stone) const;
+    Ownership finalOwnership() const;
+
+    bool doMove(int x, int y, Stone stone);
+    void undoMove();
+    void doPass(Stone stone);
+    void undoPass();
+
+    uint64_t getHash() const;
+    void setKoRule(KoRule rule);
+    KoRule getKoRule() const;
     void printBoard(std::string title = "") const;
 
+    GoEngine transformed(Symmetry s) const;
+    uint64_t getHash(Symmetry s) const;
+    uint64_t canonicalHash() const;
+
+    // The inner engine's position, shared and immutable: one alternative per
+    // alternative of Variant. restore() throws std::invalid_argument for a
+    // snapshot of another board size.
+    using Snapshot = std::variant<BasicGoEngine<9>::SharedSnapshot, BasicGoEngine<13>::SharedSnapshot,
+                                  BasicGoEngine<19>::SharedSnapshot, BasicGoEngine<0>::SharedSnapshot,
+                                  BasicGoEngine<0, MAX_BOARD_SIZE>::SharedSnapshot>;
+    Snapshot snapshot() const;
+    void restore(const Snapshot& snapshot);
+
+    // Hears about every move made with placeStone or passTurn, not the
+    // doMove and doPass of a search; nullptr stops it. Copies of this engine
+    // start without one, so nothing played on a copy is reported.
+    void setMoveObserver(MoveObserver observer) { this->observer.callback = std::move(observer); }
+
+    // Calls f with the engine inside, a BasicGoEngine of one of the
+    // Variant's sizes
+    template <typename F>
+    decltype(auto) visit(F&& f) {
+        return std::visit([&](auto& e) -> decltype(auto) { return f(unbox(e)); }, engine);
+    }
+    template <typename F>
+    decltype(auto) visit(F&& f) const {
+        return std::visit([&](const auto& e) -> decltype(auto) { return f(unbox(e)); }, engine);
+    }
+
 private:
-    int boardSize;
-    Stone lastPlayer;
-    std::vector<std::vector<Stone>> board;
-    std::pair<int, int> lastMove;
+    // Belongs to the engine it was set on: a copy starts without one, and
+    // assigning another position to the engine keeps it
+    struct ObserverSlot {
+        MoveObserver callback;
+
+        ObserverSlot() = default;
+        ObserverSlot(const ObserverSlot&) {}
+        ObserverSlot(ObserverSlot&&) = default;
+        ObserverSlot& operator=(const ObserverSlot&) { return *this; }
+        ObserverSlot& operator=(ObserverSlot&&) { return *this; }
+    };
+
+    int stride;     // kept here too, so point arithmetic needs no dispatch
+    Variant engine;
+    ObserverSlot observer;
+
+    GoEngine(int stride, Variant&& engine) : stride(stride), engine(std::move(engine)) {}
+    static Variant makeEngine(int size);
+    bool placeObserved(int point, Stone stone);     // placeStone and passTurn with an observer set
+    void passObserved(Stone stone);
 
-    void countLibertiesHelper(int x, int y, Stone stone, std::vector<std::vector<bool>>& visited, std::unordered_set<std::pair<int, int>, PairHash>& liberties) const;
-    void captureStones(int x, int y, Stone stone);
-    void captureStones(int x, int y, Stone stone, std::vector<std::vector<bool>>& visited);
-    void removeGroup(int x, int y, Stone stone);
+    template <typename T>
+    static T& unbox(T& e) { return e; }
+    template <typename T>
+    static T& unbox(Boxed<T>& e) { return *e; }
+    template <typename T>
+    static const T& unbox(const Boxed<T>& e) { return *e; }
 };
 
-#endif // GO_ENGINE_HPP
\ No newline at end of file
+#endif // GO_ENGINE_HPP
@@ -0,0 +1,86 @@
+#ifndef LIFE_AND_DEATH_HPP
+#define LIFE_AND_DEATH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "go_engine.hpp"
+
+template <typename Engine>
+class ProofSearch;
+
+enum LifeStatus {
+    ALIVE,
+    DEAD,
+    KO,             // dies if the attacker wins the ko, lives if the defender does
+    SEKI,           // lives without being able to capture the attacking chains it shares liberties with
+    UNRESOLVED,     // out of nodes, or the region is too large
+};
+
+struct LifeAndDeath {
+    LifeStatus status = UNRESOLVED;
+    int keyMove = PASS;     // the move that decides the status for the side to move; PASS if none is needed or none helps
+    int64_t nodes = 0;
+};
+
+struct LifeAndDeathOptions {
+    int threads = 0;                        // root moves are shared out; 0 uses every hardware thread
+    int64_t maxNodes = 200000;              // per solve, over every thread and reading
+    size_t tableBytes = size_t(4) << 20;    // proof and disproof numbers
+};
+
+// The empty points and defender stones connected to the chain at point,
+// plus any attacking chain whose liberties all lie among them: the area the
+// chain lives or dies in once the board is settled
+Bitboard enclosedRegion(const GoEngine& position, int point);
+
+// Reads whether the chain at a point lives when both sides play only inside
+// a region, by depth-first proof-number search (df-pn). The attacker wants to
+// capture the chain; the defender lives when the attacker cannot, which
+// includes both sides passing in a row and the chain having two liberties
+// that only it touches.
+//
+// Each root move is read to the end by one thread, on its own copy of the
+// position; all threads share a lock-free table of proof and disproof
+// numbers (key ^ data, as in TranspositionTable) that persists across solves.
+// Ko is read twice: once where the defender may answer every ko capture with
+// a threat elsewhere and once where the attacker may, which separates KO from
+// DEAD and ALIVE.
+class LifeAndDeathSolver {
+public:
+    static constexpr int MAX_REGION = 64;   // points, stones included
+    static constexpr int KO_THREATS = 2;    // per reading, for the side allowed them
+
+    explicit LifeAndDeathSolver(const LifeAndDeathOptions& options = LifeAndDeathOptions());
+
+    // The status of the chain at point with toMove to play; the region
+    // defaults to enclosedRegion. Throws std::invalid_argument if there is
+    // no stone at point.
+    LifeAndDeath solve(const GoEngine& position, int point, Stone toMove);
+    LifeAndDeath solve(const GoEngine& position, int point, const Bitboard& region, Stone toMove);
+
+private:
+    template <typename Engine>
+    friend class ProofSearch;
+
+    enum Outcome { PROVEN, DISPROVEN, OPEN };
+    struct Context;
+
+    struct Entry {
+        std::atomic<uint64_t> check{0};     // key ^ data
+        std::atomic<uint64_t> data{0};      // proof number << 32 | disproof number
+    };
+
+    LifeAndDeathOptions options;
+    std::unique_ptr<Entry[]> table;
+    size_t entryCount = 0;
+    uint64_t solves = 0;    // salts the keys, so old entries never match
+
+    Outcome read(Context& context, const GoEngine& position, Stone toMove, int& keyMove);
+    bool probe(uint64_t key, uint32_t& proof, uint32_t& disproof) const;
+    void store(uint64_t key, uint32_t proof, uint32_t disproof);
+};
+
+#endif // LIFE_AND_DEATH_HPP
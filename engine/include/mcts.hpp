@@ -0,0 +1,107 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "go_engine.hpp"
+#include "transposition_table.hpp"
+
+struct SearchOptions {
+    int threads = 0;            // 0 uses every hardware thread
+    double exploration = 0.7;   // UCT constant
+    int virtualLoss = 3;        // visits charged as losses while a thread is below a node
+    double komi = 7.5;
+    uint64_t seed = 1;
+    size_t memoryBytes = size_t(512) << 20;  // tree nodes; 0 for no limit
+    TranspositionTable* transpositions = nullptr;  // optional, may be shared with other searches
+};
+
+// The search stops at whichever limit is reached first; 0 means no limit
+struct SearchBudget {
+    int64_t playouts = 10000;
+    double seconds = 0;
+};
+
+struct SearchResult {
+    int bestMove = PASS;                        // point, or PASS
+    std::vector<std::pair<int, int>> visits;    // root children as (move, visits)
+    double winRate = 0.5;                       // for the player to move, after bestMove
+    int64_t playouts = 0;
+    int64_t nodes = 0;                          // tree nodes, including any reused
+    double seconds = 0;
+    double playoutsPerSecond = 0;
+};
+
+// Monte Carlo tree search with UCT selection and light random playouts.
+// All threads share one tree: visit and value counters are atomic, virtual
+// loss spreads concurrent descents over different children, and a leaf is
+// expanded by whichever thread wins a compare-and-swap on its state while
+// the others simply run a playout from it.
+//
+// Nodes live in an arena, so the tree survives between searches: advance()
+// keeps the subtree under a played move and drops the rest in one go, and a
+// search from the position it leads to carries on from there. A search
+// grows the tree into half the memory budget, which leaves advance() the
+// other half to copy the kept subtree into before the old tree goes. Once
+// that half is spent the tree stops growing and the search goes on with
+// playouts from its leaves.
+//
+// With a transposition table, every visit is also recorded under the hash of
+// the position it passed through, and selection values a child by whichever
+// of its own and its position's statistics has seen more playouts, so a
+// position reached by several move orders is evaluated only once.
+class Mcts {
+public:
+    explicit Mcts(const SearchOptions& options = SearchOptions());
+    ~Mcts();
+
+    // Reuses the tree when position is the one the last search or advance() left
+    SearchResult search(const GoEngine& position, const SearchBudget& budget);
+
+    // Moves the root along a played move (a point or PASS)
+    void advance(int move);
+    void clear();
+
+    int64_t getTreeSize() const { return treeNodes; }
+    size_t getMemoryUsed() const { return arena.bytesInUse(); }
+
+private:
+    struct Node {
+        enum State : uint8_t { LEAF, EXPANDING, EXPANDED };
+
+        int move = PASS;                    // move that led here
+        Stone player = EMPTY;               // who played it
+        int childCount = 0;                 // written before children is published
+        std::atomic<Node*> children{nullptr};
+        std::atomic<uint8_t> state{LEAF};
+        std::atomic<int> visits{0};
+        std::atomic<int> virtualLoss{0};
+        std::atomic<double> wins{0};        // from player's point of view
+        std::atomic<uint64_t> hash{0};      // position after move, once visited
+    };
+    struct Context;
+    using NodeArena = Arena<Node>;
+
+    SearchOptions options;
+    size_t budgetBytes = 0;     // the arena's limit while advance() copies; searches get half
+    NodeArena arena;
+    std::unique_ptr<NodeArena::Region> tree;
+    Node* root = nullptr;
+    std::optional<GoEngine> rootPosition;
+    int64_t treeNodes = 0;
+
+    void runWorker(Context& context, int index);
+    template <typename Engine>
+    void runIterations(Context& context, const Engine& position, int index);
+    Node* selectChild(Node* node) const;
+    template <typename Engine>
+    bool expand(Context& context, Node* node, const Engine& engine, NodeArena::Cursor& cursor);
+};
+
+#endif // MCTS_HPP
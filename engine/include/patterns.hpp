@@ -0,0 +1,28 @@
+#ifndef PATTERNS_HPP
+#define PATTERNS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "go_engine.hpp"
+
+// One weight per 3x3 pattern code (see PatternTable), for playout policies
+// that pick moves in proportion to the pattern around them
+class PatternWeights {
+public:
+    explicit PatternWeights(float defaultWeight = 1.0f) : weights(PatternTable::CODES, defaultWeight) {}
+
+    // Reads "code weight" lines; blank lines and lines starting with '#' are
+    // skipped and codes not listed keep their weight. Throws
+    // std::runtime_error naming the line of any malformed entry.
+    void load(const std::string& path);
+
+    float operator[](uint16_t code) const { return weights[code]; }
+    void set(uint16_t code, float weight) { weights.at(code) = weight; }
+
+private:
+    std::vector<float> weights;
+};
+
+#endif // PATTERNS_HPP
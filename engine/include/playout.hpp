@@ -0,0 +1,59 @@
+#ifndef PLAYOUT_HPP
+#define PLAYOUT_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "go_engine.hpp"
+
+// PCG32: small, fast and good enough for playouts; one per thread
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0x853C49E6748FEA9BULL) : state(seed) {}
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+    }
+
+    // Uniform in [0, bound)
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+    }
+
+private:
+    uint64_t state;
+};
+
+// Plays uniformly random legal moves, never filling the mover's own true eyes,
+// until both sides pass in a row or 3 * size * size moves have been made.
+// Returns the Tromp-Taylor area score from black's side, without komi.
+// Nothing is allocated per move as long as the engine uses SIMPLE_KO.
+int playout(GoEngine& engine, Rng& rng);
+template <int N, int MAX_N>
+int playout(BasicGoEngine<N, MAX_N>& engine, Rng& rng);
+
+// Who ends up with each point over many playouts, for positions
+// finalOwnership() cannot settle
+struct OwnershipEstimate {
+    static constexpr float DEAD_OWNERSHIP = 0.5f;   // how far a chain's mean must lean to the other side
+
+    int size = 0;
+    int playouts = 0;
+    std::vector<float> ownership;   // row by row: the fraction of playouts black owns a point minus the fraction white does
+    Bitboard dead;                  // stones finalOwnership() finds dead, and other chains outside seki that lean past DEAD_OWNERSHIP
+
+    float at(int x, int y) const { return ownership[y * size + x]; }
+};
+
+// Plays the given number of playouts from position. They are dealt out in
+// small chunks, and a worker that runs out of its own chunks steals from the
+// others. Each worker has its own Rng, reseeded from the position's hash for
+// each chunk, and its own counts, added up at the end. The result does not
+// depend on the number of threads; 0 uses every hardware thread.
+OwnershipEstimate estimateOwnership(const GoEngine& position, int playouts, int threads = 0);
+
+#endif // PLAYOUT_HPP
@@ -0,0 +1,93 @@
+#ifndef SGF_HPP
+#define SGF_HPP
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "go_engine.hpp"
+
+// Read-only memory map of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path); // throws std::runtime_error
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view contents() const { return {data, size}; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+class SgfError : public std::runtime_error {
+public:
+    SgfError(const std::string& message, size_t offset)
+        : std::runtime_error(message + " at byte " + std::to_string(offset)), offset(offset) {}
+
+    size_t offset;
+};
+
+struct SgfMove {
+    Stone color;
+    int x;      // -1 for a pass
+    int y;
+};
+
+// The main line of one game. The views point into the text the reader was
+// given and are only valid while it is.
+struct SgfGame {
+    int size = 19;
+    double komi = 0;
+    std::string_view result;        // RE, as written
+    std::vector<SgfMove> setup;     // AB and AW stones of the root node
+    std::vector<SgfMove> moves;     // B and W along the first variation at every branch
+
+    void clear();
+};
+
+// Streaming reader for SGF collections. It walks the text once without
+// copying it: each call to next() parses one game tree, follows its first
+// variation at every branch and skips the others. Property values are not
+// unescaped, which none of the properties read here need.
+class SgfReader {
+public:
+    explicit SgfReader(std::string_view text) : text(text) {}
+
+    // Reads the next game of the collection; false once there are no more.
+    // Throws SgfError for malformed text. game's vectors keep their capacity.
+    bool next(SgfGame& game);
+
+    size_t getOffset() const { return pos; }
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+
+    void skipWhitespace();
+    std::string_view readValue();
+    void readNode(SgfGame& game, bool root);
+    void skipTree();
+    void readPoints(std::string_view value, Stone color, const SgfGame& game, std::vector<SgfMove>& out);
+    [[noreturn]] void fail(const char* message) const;
+};
+
+struct ReplayReport {
+    int moves = 0;                  // main-line moves played, passes included
+    std::vector<int> illegalMoves;  // 0-based indices into SgfGame::moves
+};
+
+// Plays the game's setup stones and main line on engine, which must be empty
+// and of the game's size. An illegal move is recorded and replaced by a pass
+// so the rest of the game can still be played. A player moving twice in a
+// row, as after handicap stones, is given an implicit pass by the opponent.
+// onMove, if set, sees the position before every move.
+ReplayReport replay(const SgfGame& game, GoEngine& engine,
+                    const std::function<void(const GoEngine&, const SgfMove&)>& onMove = nullptr);
+
+#endif // SGF_HPP
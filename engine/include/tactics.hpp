@@ -0,0 +1,68 @@
+#ifndef TACTICS_HPP
+#define TACTICS_HPP
+
+#include <array>
+#include <cstdint>
+
+#include "go_engine.hpp"
+
+template <typename Engine>
+class TacticalSearch;
+
+// Local reading of captures and ladders. Each query names a chain by any of
+// its stones and reads on the engine itself with doMove/undoMove, leaving it
+// exactly as it was. The attacker is the chain's opponent; whoever the query
+// needs to move first does so, with a pass inserted for the other side if it
+// is not their turn.
+//
+// The defender answers by extending from a liberty or by capturing an
+// adjacent chain in atari, and a chain that reaches 4 liberties counts as
+// safe. The attacker plays on the chain's liberties. Moves that put the chain
+// in atari are free, so ladders are read to the end, and any other attacking
+// move uses up one unit of depth.
+//
+// Results are cached by position hash in a small table kept between queries.
+// Nothing is allocated as long as the engine uses SIMPLE_KO. A query that
+// runs out of nodes counts the chain as safe.
+class TacticalReader {
+public:
+    static constexpr int CACHE_ENTRIES = 4096;
+    static constexpr int ESCAPE_DEPTH = 3;
+
+    explicit TacticalReader(int maxNodes = 10000) : maxNodes(maxNodes) {}
+
+    // A chain in atari whose every escape ends in a ladder, or a chain with
+    // two liberties that the attacker, moving first, can ladder
+    bool isLadderCaptured(GoEngine& engine, int point);
+    // False only for a chain in atari that cannot get out, even with the
+    // attacker allowed ESCAPE_DEPTH non-atari moves
+    bool canEscapeAtari(GoEngine& engine, int point);
+    // Whether the attacker, moving first, captures the chain using at most
+    // depth moves that do not give atari
+    bool canCapture(GoEngine& engine, int point, int depth);
+
+    template <int N, int MAX_N>
+    bool isLadderCaptured(BasicGoEngine<N, MAX_N>& engine, int point);
+    template <int N, int MAX_N>
+    bool canEscapeAtari(BasicGoEngine<N, MAX_N>& engine, int point);
+    template <int N, int MAX_N>
+    bool canCapture(BasicGoEngine<N, MAX_N>& engine, int point, int depth);
+
+    int64_t getNodes() const { return nodes; }      // positions visited, over all queries
+    void clear();                                   // empties the cache
+
+private:
+    template <typename Engine>
+    friend class TacticalSearch;
+
+    struct CacheEntry {
+        uint64_t key = 0;
+        bool captured = false;
+    };
+
+    int maxNodes;
+    int64_t nodes = 0;
+    std::array<CacheEntry, CACHE_ENTRIES> cache;
+};
+
+#endif // TACTICS_HPP
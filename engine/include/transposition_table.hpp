@@ -0,0 +1,67 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Search statistics for one position, from the point of view of the player
+// who moved into it (the hash includes whose turn it is, so that is fixed)
+struct PositionStats {
+    uint32_t visits = 0;
+    double wins = 0;    // kept to the nearest half, so draws are exact
+};
+
+// Fixed-size hash table of PositionStats shared by every search thread
+// without locks. Each bucket is one cache line of four entries; an entry
+// stores its packed data next to key ^ data, so a reader that catches a
+// half-written entry sees a key mismatch and treats it as a miss (Hyatt's
+// lockless hashing). Concurrent updates to one entry can lose an increment,
+// which costs a little accuracy and never corrupts anything.
+//
+// When a bucket is full, a new position evicts the entry left over from the
+// oldest search, then the one with the fewest visits.
+class TranspositionTable {
+public:
+    static constexpr int BUCKET_ENTRIES = 4;
+
+    // Rounds down to a power-of-two number of buckets, at least one
+    explicit TranspositionTable(size_t bytes);
+
+    void resize(size_t bytes);
+    void clear();
+    size_t getSize() const { return bucketCount * sizeof(Bucket); }
+
+    // Call once per search; entries not touched since become first to go
+    void newSearch();
+
+    bool probe(uint64_t key, PositionStats& stats) const;
+    void store(uint64_t key, const PositionStats& stats);
+    void add(uint64_t key, int visits, double wins);
+
+    // Share of sampled entries written during the current search, per mille
+    int hashfull() const;
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};     // key ^ data
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_ENTRIES];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    uint8_t age = 0;
+
+    Bucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+    uint64_t pack(const PositionStats& stats) const;
+    static PositionStats unpack(uint64_t data);
+    static uint8_t ageOf(uint64_t data);
+    void write(uint64_t key, uint64_t data);
+};
+
+#endif // TRANSPOSITION_TABLE_HPP
@@ -0,0 +1,151 @@
+#include "features.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void checkSpec(const FeatureSpec& spec) {
+    if (spec.history < 0 || spec.history > MOVE_HISTORY) {
+        throw std::invalid_argument("Feature history must be between 0 and " + std::to_string(MOVE_HISTORY));
+    }
+}
+
+// Works on the engine inside the wrapper, so every read below is inlined;
+// the planes are cleared once and only the set points are visited
+template <typename T, typename Engine>
+void writePlanes(const Engine& engine, const FeatureSpec& spec, T* out) {
+    int size = engine.getBoardSize();
+    int stride = engine.getStride();
+    int planes = spec.planeCount();
+    size_t area = size_t(size) * size;
+    std::fill(out, out + area * planes, T(0));
+
+    // Both layouts are a plane stride plus a point stride
+    size_t planeStride = spec.layout == NCHW ? area : 1;
+    size_t pointStride = spec.layout == NCHW ? 1 : planes;
+    auto set = [&](int plane, int point) {
+        int x = point % stride - 1;
+        int y = point / stride - 1;
+        out[plane * planeStride + (size_t(y) * size + x) * pointStride] = T(1);
+    };
+
+    Stone player = engine.getPlayerToMove();
+    Stone opponent = player == BLACK ? WHITE : BLACK;
+    for (Stone color : {player, opponent}) {
+        int plane = color == player ? OWN_STONES : OPPONENT_STONES;
+        engine.getStones(color).forEach([&](int point) {
+            set(plane, point);
+            set(LIBERTIES_1 + std::min(engine.countLiberties(point), 4) - 1, point);
+        });
+    }
+
+    if (engine.getKoPoint() != 0) {
+        set(KO_POINT, engine.getKoPoint());
+    }
+    engine.legalMask(player).forEach([&](int point) { set(LEGAL_MOVES, point); });
+    for (int i = 0; i < spec.history; ++i) {
+        int move = engine.getRecentMove(i);
+        if (move > 0) {
+            set(HISTORY_PLANES + i, move);
+        }
+    }
+}
+
+template <typename T>
+void extractOne(const GoEngine& position, const FeatureSpec& spec, T* out) {
+    checkSpec(spec);
+    position.visit([&](const auto& engine) { writePlanes(engine, spec, out); });
+}
+
+template <typename T>
+void extractBatch(std::span<const GoEngine* const> positions, const FeatureSpec& spec, T* out, int threads) {
+    checkSpec(spec);
+    if (positions.empty()) {
+        return;
+    }
+    int size = positions[0]->getBoardSize();
+    for (const GoEngine* position : positions) {
+        if (position->getBoardSize() != size) {
+            throw std::invalid_argument("Every position in a batch must have the same board size");
+        }
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t count = positions.size();
+    size_t workers = std::min<size_t>(threads, count);
+    size_t stride = spec.tensorSize(size);
+
+    // Contiguous shares, so each thread writes its own stretch of the tensor
+    auto work = [&](size_t worker) {
+        for (size_t i = count * worker / workers; i < count * (worker + 1) / workers; ++i) {
+            positions[i]->visit([&](const auto& engine) { writePlanes(engine, spec, out + i * stride); });
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t worker = 1; worker < workers; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+template <typename T>
+void transformTensor(const FeatureSpec& spec, int boardSize, Symmetry s, const T* in, T* out) {
+    checkSpec(spec);
+    const SymmetryTable& table = SymmetryTable::forSize(boardSize);
+    int area = boardSize * boardSize;
+    int planes = spec.planeCount();
+
+    if (spec.layout == NCHW) {
+        for (int plane = 0; plane < planes; ++plane) {
+            const T* from = in + size_t(plane) * area;
+            T* to = out + size_t(plane) * area;
+            for (int i = 0; i < area; ++i) {
+                to[table.transformIndex(s, i)] = from[i];
+            }
+        }
+    } else {
+        // Each point's planes move together
+        for (int i = 0; i < area; ++i) {
+            T* to = out + size_t(table.transformIndex(s, i)) * planes;
+            std::memcpy(to, in + size_t(i) * planes, planes * sizeof(T));
+        }
+    }
+}
+
+} // namespace
+
+void extractFeatures(const GoEngine& position, const FeatureSpec& spec, float* out) {
+    extractOne(position, spec, out);
+}
+
+void extractFeatures(const GoEngine& position, const FeatureSpec& spec, uint8_t* out) {
+    extractOne(position, spec, out);
+}
+
+void extractFeatures(std::span<const GoEngine* const> positions, const FeatureSpec& spec, float* out,
+                     int threads) {
+    extractBatch(positions, spec, out, threads);
+}
+
+void extractFeatures(std::span<const GoEngine* const> positions, const FeatureSpec& spec, uint8_t* out,
+                     int threads) {
+    extractBatch(positions, spec, out, threads);
+}
+
+void transformFeatures(const FeatureSpec& spec, int boardSize, Symmetry s, const float* in, float* out) {
+    transformTensor(spec, boardSize, s, in, out);
+}
+
+void transformFeatures(const FeatureSpec& spec, int boardSize, Symmetry s, const uint8_t* in, uint8_t* out) {
+    transformTensor(spec, boardSize, s, in, out);
+}
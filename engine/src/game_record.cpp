@@ -0,0 +1,311 @@
+#include "game_record.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// The format is little-endian and read in place
+static_assert(std::endian::native == std::endian::little, "game records are read without byte swapping");
+
+namespace {
+
+constexpr char MAGIC[4] = {'G', 'O', 'G', 'R'};
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t gameCount;
+    uint64_t indexOffset;
+};
+
+struct RecordHeader {
+    uint8_t size;
+    uint8_t winner;
+    uint8_t reason;
+    uint8_t reserved;
+    int16_t komi;       // half points
+    int16_t margin;     // half points
+    uint16_t setupCount;
+    uint16_t reserved2;
+    uint32_t moveCount;
+};
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(RecordHeader) == 16);
+
+// Move codes: point y*size+x, then flags
+constexpr uint16_t POINT_MASK = (1 << 12) - 1;
+constexpr uint16_t PASS_FLAG = 1 << 12;
+constexpr uint16_t WHITE_FLAG = 1 << 15;
+
+static_assert(MAX_BOARD_SIZE * MAX_BOARD_SIZE <= POINT_MASK + 1);
+
+uint16_t encode(const SgfMove& move, int size) {
+    uint16_t code = move.color == WHITE ? WHITE_FLAG : 0;
+    if (move.x < 0) {
+        return code | PASS_FLAG;
+    }
+    return code | static_cast<uint16_t>(move.y * size + move.x);
+}
+
+int16_t halfPoints(double points) {
+    long halves = std::lround(points * 2);
+    return static_cast<int16_t>(std::max<long>(INT16_MIN, std::min<long>(INT16_MAX, halves)));
+}
+
+} // namespace
+
+GameResult parseResult(std::string_view text) {
+    GameResult result;
+    if (text == "0" || text == "Draw" || text == "Jigo") {
+        result.reason = GameResult::DRAW;
+        return result;
+    }
+    if (text == "Void") {
+        result.reason = GameResult::VOID;
+        return result;
+    }
+    if (text.size() < 2 || text[1] != '+' || (text[0] != 'B' && text[0] != 'W')) {
+        return result;
+    }
+
+    result.winner = text[0] == 'B' ? BLACK : WHITE;
+    std::string_view how = text.substr(2);
+    if (how == "R" || how == "Resign") {
+        result.reason = GameResult::RESIGN;
+    } else if (how == "T" || how == "Time") {
+        result.reason = GameResult::TIME;
+    } else if (how == "F" || how == "Forfeit") {
+        result.reason = GameResult::FORFEIT;
+    } else {
+        double margin = 0;
+        auto [end, error] = std::from_chars(how.data(), how.data() + how.size(), margin);
+        if (!how.empty() && error == std::errc() && end == how.data() + how.size()) {
+            result.reason = GameResult::SCORE;
+            result.margin = halfPoints(margin) / 2.0;
+        }
+    }
+    return result;
+}
+
+std::string toString(const GameResult& result) {
+    switch (result.reason) {
+    case GameResult::DRAW:
+        return "0";
+    case GameResult::VOID:
+        return "Void";
+    default:
+        break;
+    }
+    if (result.winner != BLACK && result.winner != WHITE) {
+        return "?";
+    }
+
+    std::string text = result.winner == BLACK ? "B+" : "W+";
+    switch (result.reason) {
+    case GameResult::RESIGN:
+        return text + "R";
+    case GameResult::TIME:
+        return text + "T";
+    case GameResult::FORFEIT:
+        return text + "F";
+    case GameResult::SCORE: {
+        char buffer[32];
+        auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), result.margin);
+        return text + std::string(buffer, end);
+    }
+    default:
+        return text;
+    }
+}
+
+SgfMove GameRecord::decode(uint16_t code) const {
+    Stone color = code & WHITE_FLAG ? WHITE : BLACK;
+    if (code & PASS_FLAG) {
+        return SgfMove{color, -1, -1};
+    }
+    int point = code & POINT_MASK;
+    return SgfMove{color, point % size, point / size};
+}
+
+GameRecordWriter::GameRecordWriter(const std::string& path) : path(path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot create " + path + ": " + std::strerror(errno));
+    }
+    // Filled in by close()
+    FileHeader header{};
+    write(&header, sizeof(header));
+}
+
+GameRecordWriter::~GameRecordWriter() {
+    if (file) {
+        try {
+            close();
+        } catch (const std::runtime_error&) {
+            // Nowhere to report it; the file is left without a valid header
+        }
+    }
+}
+
+void GameRecordWriter::write(const void* data, size_t bytes) {
+    if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+        throw std::runtime_error("Cannot write " + path + ": " + std::strerror(errno));
+    }
+    offset += bytes;
+}
+
+void GameRecordWriter::add(const SgfGame& game) {
+    if (!file) {
+        throw std::runtime_error("Writing to closed game record file " + path);
+    }
+    if (game.size < 1 || game.size > MAX_BOARD_SIZE) {
+        throw std::invalid_argument("Board size must be between 1 and " + std::to_string(MAX_BOARD_SIZE));
+    }
+    if (game.setup.size() > UINT16_MAX || game.moves.size() > UINT32_MAX) {
+        throw std::invalid_argument("Game too long for a game record");
+    }
+
+    GameResult result = parseResult(game.result);
+    RecordHeader header{};
+    header.size = static_cast<uint8_t>(game.size);
+    header.winner = static_cast<uint8_t>(result.winner);
+    header.reason = result.reason;
+    header.komi = halfPoints(game.komi);
+    header.margin = halfPoints(result.margin);
+    header.setupCount = static_cast<uint16_t>(game.setup.size());
+    header.moveCount = static_cast<uint32_t>(game.moves.size());
+
+    buffer.clear();
+    for (const SgfMove& stone : game.setup) {
+        buffer.push_back(encode(stone, game.size));
+    }
+    for (const SgfMove& move : game.moves) {
+        buffer.push_back(encode(move, game.size));
+    }
+
+    offsets.push_back(offset);
+    write(&header, sizeof(header));
+    write(buffer.data(), buffer.size() * sizeof(uint16_t));
+}
+
+void GameRecordWriter::close() {
+    if (!file) {
+        return;
+    }
+
+    // Align the index so readers can use it in place
+    static const char padding[8] = {};
+    write(padding, (8 - offset % 8) % 8);
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.gameCount = offsets.size();
+    header.indexOffset = offset;
+    write(offsets.data(), offsets.size() * sizeof(uint64_t));
+
+    bool ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    if (!ok) {
+        throw std::runtime_error("Cannot finish " + path + ": " + std::strerror(errno));
+    }
+}
+
+GameRecordReader::GameRecordReader(const std::string& path) : file(path) {
+    std::string_view data = file.contents();
+    FileHeader header;
+    if (data.size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a game record file");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a game record file");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error(path + " has unsupported game record version " + std::to_string(header.version));
+    }
+    if (header.indexOffset < sizeof(header) || header.indexOffset % 8 != 0 || header.indexOffset > data.size() ||
+        header.gameCount > (data.size() - header.indexOffset) / sizeof(uint64_t)) {
+        throw std::runtime_error(path + " has a damaged index");
+    }
+
+    index = reinterpret_cast<const uint64_t*>(data.data() + header.indexOffset);
+    gameCount = header.gameCount;
+}
+
+GameRecord GameRecordReader::getGame(size_t i) const {
+    if (i >= gameCount) {
+        throw std::out_of_range("Game " + std::to_string(i) + " of " + std::to_string(gameCount));
+    }
+
+    // Games live between the file header and the index
+    std::string_view data = file.contents();
+    uint64_t end = reinterpret_cast<const char*>(index) - data.data();
+    uint64_t begin = index[i];
+    RecordHeader header;
+    if (begin < sizeof(FileHeader) || begin % 2 != 0 || begin > end - sizeof(header)) {
+        throw std::runtime_error("Game " + std::to_string(i) + " has a damaged offset");
+    }
+    std::memcpy(&header, data.data() + begin, sizeof(header));
+
+    uint64_t codes = uint64_t(header.setupCount) + header.moveCount;
+    if (header.size < 1 || header.size > MAX_BOARD_SIZE || codes > (end - begin - sizeof(header)) / 2) {
+        throw std::runtime_error("Game " + std::to_string(i) + " is damaged");
+    }
+
+    GameRecord game;
+    game.size = header.size;
+    game.komi = header.komi / 2.0;
+    game.result.winner = header.winner == BLACK || header.winner == WHITE ? static_cast<Stone>(header.winner) : EMPTY;
+    game.result.reason = header.reason <= GameResult::VOID ? static_cast<GameResult::Reason>(header.reason)
+                                                           : GameResult::UNKNOWN;
+    game.result.margin = header.margin / 2.0;
+    game.setupData = reinterpret_cast<const uint16_t*>(data.data() + begin + sizeof(header));
+    game.moveData = game.setupData + header.setupCount;
+    game.setupCount = header.setupCount;
+    game.moveCount = static_cast<int>(header.moveCount);
+
+    // A bad point would send replay off the board
+    int points = game.size * game.size;
+    for (uint64_t j = 0; j < codes; ++j) {
+        uint16_t code = game.setupData[j];
+        if (!(code & PASS_FLAG) && (code & POINT_MASK) >= points) {
+            throw std::runtime_error("Game " + std::to_string(i) + " has a move off the board");
+        }
+    }
+    return game;
+}
+
+size_t convertSgf(std::string_view text, GameRecordWriter& writer) {
+    SgfReader reader(text);
+    SgfGame game;
+    size_t games = 0;
+    while (reader.next(game)) {
+        writer.add(game);
+        games++;
+    }
+    return games;
+}
+
+ReplayReport replay(const GameRecord& record, GoEngine& engine,
+                    const std::function<void(const GoEngine&, const SgfMove&)>& onMove) {
+    // Decoding into a game keeps the rules in one place; the vectors keep
+    // their capacity from game to game
+    static thread_local SgfGame game;
+    game.clear();
+    game.size = record.size;
+    game.komi = record.komi;
+    for (int i = 0; i < record.getSetupCount(); ++i) {
+        game.setup.push_back(record.getSetup(i));
+    }
+    for (int i = 0; i < record.getMoveCount(); ++i) {
+        game.moves.push_back(record.getMove(i));
+    }
+    return replay(game, engine, onMove);
+}
@@ -1,142 +1,1579 @@
 #include "go_engine.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
-#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 
-GoEngine::GoEngine(int size)
-    : boardSize(size), board(size, std::vector<Stone>(size, EMPTY)), lastMove(-1, -1), lastPlayer(EMPTY) {}
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GO_ENGINE_HAVE_AVX2 1
+#endif
 
-int GoEngine::getBoardSize() const {
+namespace {
+
+// Both kernels read the words through a copy with a zero word on either side,
+// so the carries into the first and last words need no special cases
+constexpr int PADDED_WORDS = Bitboard::WORDS + 2;
+
+void dilateScalar(const uint64_t* in, uint64_t* out, int begin, int end, int stride) {
+    for (int i = begin + 1; i <= end; ++i) {
+        uint64_t word = in[i];
+        uint64_t below = in[i - 1];
+        uint64_t above = in[i + 1];
+        out[i - 1] = word |
+                     (word << 1) | (below >> 63) |
+                     (word >> 1) | (above << 63) |
+                     (word << stride) | (below >> (64 - stride)) |
+                     (word >> stride) | (above << (64 - stride));
+    }
+}
+
+void dilateScalarAll(const uint64_t* in, uint64_t* out, int count, int stride) {
+    dilateScalar(in, out, 0, count, stride);
+}
+
+#ifdef GO_ENGINE_HAVE_AVX2
+__attribute__((target("avx2")))
+void dilateAvx2(const uint64_t* in, uint64_t* out, int count, int stride) {
+    const __m128i one = _mm_cvtsi32_si128(1);
+    const __m128i sixtyThree = _mm_cvtsi32_si128(63);
+    const __m128i up = _mm_cvtsi32_si128(stride);
+    const __m128i down = _mm_cvtsi32_si128(64 - stride);
+    int i = 1;
+    for (; i + 3 <= count; i += 4) {
+        __m256i word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i below = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i - 1));
+        __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 1));
+        __m256i result = _mm256_or_si256(word, _mm256_or_si256(_mm256_sll_epi64(word, one), _mm256_srl_epi64(below, sixtyThree)));
+        result = _mm256_or_si256(result, _mm256_or_si256(_mm256_srl_epi64(word, one), _mm256_sll_epi64(above, sixtyThree)));
+        result = _mm256_or_si256(result, _mm256_or_si256(_mm256_sll_epi64(word, up), _mm256_srl_epi64(below, down)));
+        result = _mm256_or_si256(result, _mm256_or_si256(_mm256_srl_epi64(word, up), _mm256_sll_epi64(above, down)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i - 1), result);
+    }
+    // Fewer than four words left
+    dilateScalar(in, out, i - 1, count, stride);
+}
+#endif
+
+// Zobrist keys, generated at compile time with splitmix64 so every build
+// and every engine agrees on the hash of a position
+struct ZobristKeys {
+    uint64_t stones[MAX_POINTS][3]; // indexed by point and Stone, EMPTY column unused
+    uint64_t lastPlayer[3];         // EMPTY entry is 0: nobody has moved yet
+    uint64_t ko[MAX_POINTS];        // ko[0] is 0: no ko point
+};
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x676F676F676F676FULL;
+    for (int point = 0; point < MAX_POINTS; ++point) {
+        keys.stones[point][BLACK] = splitMix64(state);
+        keys.stones[point][WHITE] = splitMix64(state);
+        keys.ko[point] = point == 0 ? 0 : splitMix64(state);
+    }
+    keys.lastPlayer[BLACK] = splitMix64(state);
+    keys.lastPlayer[WHITE] = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+using DilateKernel = void (*)(const uint64_t*, uint64_t*, int, int);
+
+DilateKernel selectDilateKernel() {
+#ifdef GO_ENGINE_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return dilateAvx2;
+    }
+#endif
+    return dilateScalarAll;
+}
+
+// Working sets of benson(), one per thread. Sized to the board at hand and
+// keeping their capacity between calls, so after the first call on a thread
+// nothing is allocated.
+struct BensonScratch {
+    std::vector<int> regionOf;
+    std::vector<int> regionPoints;          // grouped by region
+    std::vector<int> regionBegin;
+    std::vector<int> edgeBegin;
+    std::vector<std::pair<int, bool>> edges;    // per region: (chain head, vital)
+    std::vector<bool> enclosed;             // every empty point touches stone
+    std::vector<int> vitalCount;
+    std::vector<int> seen;                  // region that last touched a chain
+    std::vector<int> libertyCount;
+    std::vector<int> touched;
+    std::vector<int> chainBegin;
+    std::vector<int> chainRegions;
+    std::vector<int> fill;
+    std::vector<bool> chainFallen;
+    std::vector<bool> regionFallen;
+    std::vector<int> work;
+
+    void reset(int points) {
+        regionOf.assign(points, -1);
+        regionPoints.clear();
+        regionBegin.assign(1, 0);
+        edgeBegin.assign(1, 0);
+        edges.clear();
+        enclosed.clear();
+        vitalCount.assign(points, 0);
+        seen.assign(points, -1);
+        libertyCount.assign(points, 0);
+        touched.clear();
+        chainBegin.assign(points + 1, 0);
+        chainFallen.assign(points, false);
+        work.clear();
+    }
+};
+
+} // namespace
+
+void dilateWords(const uint64_t* words, uint64_t* out, int count, int stride) {
+    static const DilateKernel kernel = selectDilateKernel();
+
+    uint64_t padded[PADDED_WORDS];
+    padded[0] = 0;
+    std::memcpy(padded + 1, words, count * sizeof(uint64_t));
+    padded[count + 1] = 0;
+    kernel(padded, out, count, stride);
+}
+
+SymmetryTable::SymmetryTable(int size)
+    : boardSize(size), pointCount((size + 2) * (size + 2)), points(SYMMETRIES * pointCount, PASS),
+      indices(SYMMETRIES * size * size), keys(pointCount * 3 * SYMMETRIES, 0) {
+    int stride = size + 2;
+    for (int s = 0; s < SYMMETRIES; ++s) {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                auto [tx, ty] = transformCoordinates(static_cast<Symmetry>(s), x, y, size);
+                int point = (y + 1) * stride + (x + 1);
+                int image = (ty + 1) * stride + (tx + 1);
+                points[s * pointCount + point] = image;
+                indices[s * size * size + y * size + x] = ty * size + tx;
+                keys[(point * 3 + EMPTY) * SYMMETRIES + s] = ZOBRIST.ko[image];
+                keys[(point * 3 + BLACK) * SYMMETRIES + s] = ZOBRIST.stones[image][BLACK];
+                keys[(point * 3 + WHITE) * SYMMETRIES + s] = ZOBRIST.stones[image][WHITE];
+            }
+        }
+    }
+}
+
+const SymmetryTable& SymmetryTable::forSize(int size) {
+    if (size < 1 || size > MAX_BOARD_SIZE) {
+        throw std::invalid_argument("Board size must be between 1 and " + std::to_string(MAX_BOARD_SIZE));
+    }
+
+    static std::once_flag built[MAX_BOARD_SIZE + 1];
+    static std::unique_ptr<SymmetryTable> tables[MAX_BOARD_SIZE + 1];
+    std::call_once(built[size], [size] { tables[size].reset(new SymmetryTable(size)); });
+    return *tables[size];
+}
+
+void SymmetryTable::transformMoves(Symmetry s, const MoveList& moves, MoveList& out) const {
+    out.clear();
+    for (int point : moves) {
+        out.push_back(transformPoint(s, point));
+    }
+}
+
+PatternTable::PatternTable(int size)
+    : bases((size + 2) * (size + 2), 0), weights(bases.size() * NEIGHBORS, 0), spreads(weights.size(), 0) {
+    // Code ranges for each set of off-board sides (N, E, S, W as bits 0-3),
+    // laid end to end
+    int begin[16];
+    int next = 0;
+    for (int sides = 0; sides < 16; ++sides) {
+        begin[sides] = next;
+        int count = 1;
+        for (int d = 0; d < 4; ++d) {
+            count *= sides & (1 << d) ? 1 : 5;
+        }
+        for (int d = 0; d < 4; ++d) {
+            // A diagonal is on the board when both sides next to it are
+            count *= sides & (1 << d) || sides & (1 << (d + 1) % 4) ? 1 : 3;
+        }
+        next += count;
+    }
+    assert(next == CODES);
+
+    int stride = size + 2;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            int point = (y + 1) * stride + (x + 1);
+            int sides = (y == 0) | (x == size - 1) << 1 | (y == size - 1) << 2 | (x == 0) << 3;
+            bases[point] = static_cast<uint16_t>(begin[sides]);
+
+            int place = 1;
+            for (int d = 0; d < 4; ++d) {
+                if (!(sides & (1 << d))) {
+                    weights[point * NEIGHBORS + d] = static_cast<uint16_t>(place);
+                    place *= 5;
+                }
+            }
+            for (int d = 0; d < 4; ++d) {
+                if (!(sides & (1 << d) || sides & (1 << (d + 1) % 4))) {
+                    weights[point * NEIGHBORS + 4 + d] = static_cast<uint16_t>(place);
+                    place *= 3;
+                }
+            }
+        }
+    }
+
+    // The neighbor in direction d sees a point from the opposite direction
+    const int offsets[NEIGHBORS] = {-stride, 1, stride, -1, 1 - stride, 1 + stride, stride - 1, -stride - 1};
+    const int opposite[NEIGHBORS] = {2, 3, 0, 1, 6, 7, 4, 5};
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            int point = (y + 1) * stride + (x + 1);
+            for (int d = 0; d < NEIGHBORS; ++d) {
+                spreads[point * NEIGHBORS + d] = weights[(point + offsets[d]) * NEIGHBORS + opposite[d]];
+            }
+        }
+    }
+}
+
+const PatternTable& PatternTable::forSize(int size) {
+    if (size < 1 || size > MAX_BOARD_SIZE) {
+        throw std::invalid_argument("Board size must be between 1 and " + std::to_string(MAX_BOARD_SIZE));
+    }
+
+    static std::once_flag built[MAX_BOARD_SIZE + 1];
+    static std::unique_ptr<PatternTable> tables[MAX_BOARD_SIZE + 1];
+    std::call_once(built[size], [size] { tables[size].reset(new PatternTable(size)); });
+    return *tables[size];
+}
+
+template <int N, int MAX_N>
+BasicGoEngine<N, MAX_N>::BasicGoEngine(int size)
+    : BoardGeometry<N>(size), Snapshot(), koRule(SIMPLE_KO), patternTable(nullptr), markGeneration(0) {
+    if (size < 1 || size > MAX_N) {
+        throw std::invalid_argument("Board size must be between 1 and " + std::to_string(MAX_N));
+    }
+    if (N != 0 && size != N) {
+        throw std::invalid_argument("This engine only plays on " + std::to_string(N) + "x" + std::to_string(N));
+    }
+
+    // The rest of the position starts zeroed: EMPTY moved last, no ko, no moves
+    Snapshot::size = size;
+    board.fill(OFFBOARD);
+    recentMoves.fill(PASS);
+    chainHead.fill(0);
+    nextStone.fill(0);
+    chains.fill(Chain{0, 0});
+    marks.fill(0);
+    patterns.fill(0);
+    patternTable = &PatternTable::forSize(boardSize);
+    for (int y = 0; y < boardSize; ++y) {
+        for (int x = 0; x < boardSize; ++x) {
+            board[toIndex(x, y)] = EMPTY;
+            stoneBits[EMPTY].set(toIndex(x, y));
+            patterns[toIndex(x, y)] = patternTable->emptyCode(toIndex(x, y));
+        }
+    }
+
+    // Room for a long search line, so doMove does not allocate
+    undoStack.reserve(3 * boardSize * boardSize);
+    undoStones.reserve(3 * boardSize * boardSize);
+}
+
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::getBoardSize() const {
     return boardSize;
 }
 
-Stone GoEngine::getStoneAt(int x, int y) const {
-    return board[x][y];
+template <int N, int MAX_N>
+Stone BasicGoEngine<N, MAX_N>::getStoneAt(int x, int y) const {
+    return board[toIndex(x, y)];
 }
 
-bool GoEngine::placeStone(int x, int y, Stone stone) {
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::placeStone(int x, int y, Stone stone) {
     if (!isValidMove(x, y, stone)) {
         return false;
     }
 
-    board[x][y] = stone;
-    lastMove = {x, y};
-    lastPlayer = stone;
-    captureStones(x, y, stone);
+    play(toIndex(x, y), stone, nullptr);
     return true;
 }
 
-bool GoEngine::isValidMove(int x, int y, Stone stone) const {
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::placeStone(int point, Stone stone) {
+    // board[point] is OFFBOARD for points outside the playable area
+    if ((stone != BLACK && stone != WHITE) || lastPlayer == stone || board[point] != EMPTY ||
+        !isLegalPoint(point, stone)) {
+        return false;
+    }
+
+    play(point, stone, nullptr);
+    return true;
+}
+
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::placeStone(int point, Stone stone, MoveDelta& delta) {
+    if ((stone != BLACK && stone != WHITE) || lastPlayer == stone || board[point] != EMPTY ||
+        !isLegalPoint(point, stone)) {
+        return false;
+    }
+
+    delta.clear();
+    play(point, stone, nullptr, &delta);
+    return true;
+}
+
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::isValidMove(int x, int y, Stone stone) const {
+    if (stone != BLACK && stone != WHITE) {
+        return false;
+    }
+
     if (lastPlayer == stone) {
 //std::cout << "isValidMove, quitting due to lastPlayer == stone: " << stone << std::endl;
         return false;
     }
 
-    if (x < 0 || x >= boardSize || y < 0 || y >= boardSize || board[x][y] != EMPTY) {
+    if (x < 0 || x >= boardSize || y < 0 || y >= boardSize || board[toIndex(x, y)] != EMPTY) {
 //std::cout << "isValidMove, quitting due to board bounds:" << std::endl;
 //std::cout << "    x: " << x << std::endl;
 //std::cout << "    y: " << y << std::endl;
 //std::cout << "    boardSize: " << boardSize << std::endl;
-//std::cout << "    board[x][y]: " << board[x][y] << std::endl;
+//std::cout << "    board[x][y]: " << board[toIndex(x, y)] << std::endl;
         return false;
     }
 
+    return isLegalPoint(toIndex(x, y), stone);
+}
+
+template <int N, int MAX_N>
+Stone BasicGoEngine<N, MAX_N>::getPlayerToMove() const {
+    return lastPlayer == BLACK ? WHITE : BLACK;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::generateLegalMoves(MoveList& moves) const {
+    generateLegalMoves(moves, getPlayerToMove());
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::generateLegalMoves(MoveList& moves, Stone stone) const {
+    moves.clear();
+    if (lastPlayer == stone || (stone != BLACK && stone != WHITE)) {
+        return;
+    }
+
+    stoneBits[EMPTY].forEach([&](int point) {
+        if (isLegalPoint(point, stone)) {
+            moves.push_back(point);
+        }
+    });
+}
+
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::Bits BasicGoEngine<N, MAX_N>::legalMask(Stone stone) const {
+    Bits mask;
+    if (lastPlayer == stone || (stone != BLACK && stone != WHITE)) {
+        return mask;
+    }
+
+    stoneBits[EMPTY].forEach([&](int point) {
+        if (isLegalPoint(point, stone)) {
+            mask.set(point);
+        }
+    });
+    return mask;
+}
+
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::isTrueEye(int point, Stone stone) const {
+    if (board[point] != EMPTY) {
+        return false;
+    }
+
+    const int directions[] = {1, -1, stride, -stride};
+    for (int dir : directions) {
+        Stone other = board[point + dir];
+        if (other != stone && other != OFFBOARD) {
+            return false;
+        }
+    }
+
+    // One opponent diagonal is tolerable in the middle, none on the edge
+    Stone opponent = stone == BLACK ? WHITE : BLACK;
+    int opponentDiagonals = 0;
+    bool onEdge = false;
+    const int diagonals[] = {stride + 1, stride - 1, -stride + 1, -stride - 1};
+    for (int dir : diagonals) {
+        Stone other = board[point + dir];
+        opponentDiagonals += other == opponent;
+        onEdge = onEdge || other == OFFBOARD;
+    }
+    return opponentDiagonals + (onEdge ? 1 : 0) < 2;
+}
+
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::isLegalPoint(int point, Stone stone) const {
     // Check for Ko rule
-    if (x == lastMove.first && y == lastMove.second) {
+    if (point == koPoint) {
 //std::cout << "isValidMove, quitting due to KO rule" << std::endl;
         return false;
     }
 
-    // Check for self-capture
-    std::vector<std::vector<bool>> visited(boardSize, std::vector<bool>(boardSize, false));
-    if (countLiberties(x, y, stone) == 0) {
+    // Check for self-capture: the new stone needs an empty neighbor, a friendly
+    // chain that keeps a liberty after this move, or an opponent chain it captures
+    bool hasLiberty = false;
+    const int directions[] = {1, -1, stride, -stride};
+    for (int dir : directions) {
+        int neighbor = point + dir;
+        Stone other = board[neighbor];
+
+        if (other == EMPTY) {
+            hasLiberty = true;
+        } else if (other != OFFBOARD) {
+            int liberties = chains[chainHead[neighbor]].liberties;
+            hasLiberty = hasLiberty || (other == stone ? liberties > 1 : liberties == 1);
+        }
+    }
+
+    if (!hasLiberty) {
 //std::cout << "isValidMove, quitting due to self-capture" << std::endl;
         return false;
     }
 
+    if (koRule != SIMPLE_KO && repeatsPosition(point, stone)) {
+        return false;
+    }
+
     return true;
 }
 
-int GoEngine::countLiberties(int x, int y, Stone stone) const {
-    std::vector<std::vector<bool>> visited(boardSize, std::vector<bool>(boardSize, false));
-    std::unordered_set<std::pair<int, int>, PairHash> liberties;
-    countLibertiesHelper(x, y, stone, visited, liberties);
-    return liberties.size();
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::countLiberties(int x, int y, Stone stone) const {
+    int point = toIndex(x, y);
+    if (board[point] != stone || (stone != BLACK && stone != WHITE)) {
+        return 0;
+    }
+    return chains[chainHead[point]].liberties;
 }
 
-void GoEngine::countLibertiesHelper(int x, int y, Stone stone, std::vector<std::vector<bool>>& visited, std::unordered_set<std::pair<int, int>, PairHash>& liberties) const {
-    if (x < 0 || x >= boardSize || y < 0 || y >= boardSize || visited[x][y]) {
-        return;
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::Bits BasicGoEngine<N, MAX_N>::getGroup(int x, int y) const {
+    int point = toIndex(x, y);
+    Bits group;
+    if (board[point] != BLACK && board[point] != WHITE) {
+        return group;
     }
 
-    visited[x][y] = true;
+    // Walk the chain's ring: one step per stone, no recursion or search
+    int stone = point;
+    do {
+        group.set(stone);
+        stone = nextStone[stone];
+    } while (stone != point);
+    return group;
+}
 
-    if (board[x][y] == EMPTY) {
-        liberties.insert({x, y});
-        return;
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::Bits BasicGoEngine<N, MAX_N>::getLiberties(int x, int y) const {
+    int point = toIndex(x, y);
+    Bits liberties;
+    if (board[point] != BLACK && board[point] != WHITE) {
+        return liberties;
     }
 
-    if (board[x][y] != stone) {
-        return;
+    const int directions[] = {1, -1, stride, -stride};
+    int stone = point;
+    do {
+        for (int dir : directions) {
+            if (board[stone + dir] == EMPTY) {
+                liberties.set(stone + dir);
+            }
+        }
+        stone = nextStone[stone];
+    } while (stone != point);
+    return liberties;
+}
+
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::AreaScore BasicGoEngine<N, MAX_N>::scoreArea(double komi) const {
+    const Bits& empty = stoneBits[EMPTY];
+
+    // Grow each color into the empty points one step at a time until it
+    // stops; a step is a few word operations however many regions there are
+    auto reach = [&](const Bits& stones) {
+        Bits area = stones;
+        for (;;) {
+            Bits grown = (area.dilate(stride) & empty) | stones;
+            if (grown == area) {
+                return area;
+            }
+            area = grown;
+        }
+    };
+
+    Bits blackReach = reach(stoneBits[BLACK]);
+    Bits whiteReach = reach(stoneBits[WHITE]);
+    Bits shared = blackReach & whiteReach; // empty regions touching both colors
+
+    AreaScore result;
+    result.blackArea = blackReach ^ shared;
+    result.whiteArea = whiteReach ^ shared;
+    result.black = result.blackArea.count();
+    result.white = result.whiteArea.count();
+    result.score = result.black - result.white - komi;
+    return result;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::benson(Stone stone, Bits& alive, Bits& territory) const {
+    // Regions are the connected sets of points without stone. Each region
+    // records the chains of stone around it, and whether it is vital to a
+    // chain: every empty point of it a liberty of that chain.
+    static thread_local BensonScratch scratch;
+    const int points = stride * stride;
+    scratch.reset(points);
+    std::vector<int>& regionOf = scratch.regionOf;
+    std::vector<int>& regionPoints = scratch.regionPoints;
+    std::vector<int>& regionBegin = scratch.regionBegin;
+    std::vector<int>& edgeBegin = scratch.edgeBegin;
+    std::vector<std::pair<int, bool>>& edges = scratch.edges;
+    std::vector<bool>& enclosed = scratch.enclosed;
+    std::vector<int>& vitalCount = scratch.vitalCount;
+    std::vector<int>& seen = scratch.seen;
+    std::vector<int>& libertyCount = scratch.libertyCount;
+    std::vector<int>& touched = scratch.touched;
+
+    Stone opponent = stone == BLACK ? WHITE : BLACK;
+    (stoneBits[EMPTY] | stoneBits[opponent]).forEach([&](int start) {
+        if (regionOf[start] >= 0) {
+            return;
+        }
+        int region = static_cast<int>(enclosed.size());
+        int empties = 0;
+        int touching = 0;
+        regionOf[start] = region;
+        regionPoints.push_back(start);
+        for (size_t i = regionBegin.back(); i < regionPoints.size(); ++i) {
+            int point = regionPoints[i];
+            bool empty = board[point] == EMPTY;
+            bool touches = false;
+            int heads[4];
+            for (int j = 0, count = adjacentChains(point, heads); j < count; ++j) {
+                if (board[heads[j]] != stone) {
+                    continue;
+                }
+                touches = true;
+                if (seen[heads[j]] != region) {
+                    seen[heads[j]] = region;
+                    libertyCount[heads[j]] = 0;
+                    touched.push_back(heads[j]);
+                }
+                libertyCount[heads[j]] += empty;
+            }
+            empties += empty;
+            touching += empty && touches;
+
+            const int directions[] = {1, -1, stride, -stride};
+            for (int dir : directions) {
+                int neighbor = point + dir;
+                if ((board[neighbor] == EMPTY || board[neighbor] == opponent) && regionOf[neighbor] < 0) {
+                    regionOf[neighbor] = region;
+                    regionPoints.push_back(neighbor);
+                }
+            }
+        }
+
+        for (int head : touched) {
+            bool vital = libertyCount[head] == empties;
+            edges.emplace_back(head, vital);
+            vitalCount[head] += vital;
+        }
+        touched.clear();
+        enclosed.push_back(touching == empties);
+        regionBegin.push_back(static_cast<int>(regionPoints.size()));
+        edgeBegin.push_back(static_cast<int>(edges.size()));
+    });
+    const int regions = static_cast<int>(enclosed.size());
+
+    // The same edges indexed by chain
+    std::vector<int>& chainBegin = scratch.chainBegin;
+    for (const auto& edge : edges) {
+        chainBegin[edge.first + 1]++;
+    }
+    for (int i = 0; i < points; ++i) {
+        chainBegin[i + 1] += chainBegin[i];
+    }
+    std::vector<int>& chainRegions = scratch.chainRegions;
+    std::vector<int>& fill = scratch.fill;
+    chainRegions.resize(edges.size());
+    fill.assign(chainBegin.begin(), chainBegin.end() - 1);
+    for (int region = 0; region < regions; ++region) {
+        for (int i = edgeBegin[region]; i < edgeBegin[region + 1]; ++i) {
+            chainRegions[fill[edges[i].first]++] = region;
+        }
+    }
+
+    // A chain with fewer than two vital regions may be captured, and then
+    // no region next to it is safe; each chain and region falls at most once
+    std::vector<bool>& chainFallen = scratch.chainFallen;
+    std::vector<bool>& regionFallen = scratch.regionFallen;
+    std::vector<int>& work = scratch.work;
+    regionFallen.assign(regions, false);
+    stoneBits[stone].forEach([&](int point) {
+        if (chainHead[point] == point && vitalCount[point] < 2) {
+            chainFallen[point] = true;
+            work.push_back(point);
+        }
+    });
+    while (!work.empty()) {
+        int head = work.back();
+        work.pop_back();
+        for (int i = chainBegin[head]; i < chainBegin[head + 1]; ++i) {
+            int region = chainRegions[i];
+            if (regionFallen[region]) {
+                continue;
+            }
+            regionFallen[region] = true;
+            for (int j = edgeBegin[region]; j < edgeBegin[region + 1]; ++j) {
+                auto [other, vital] = edges[j];
+                if (vital && --vitalCount[other] < 2 && !chainFallen[other]) {
+                    chainFallen[other] = true;
+                    work.push_back(other);
+                }
+            }
+        }
+    }
+
+    alive = Bits();
+    territory = Bits();
+    stoneBits[stone].forEach([&](int point) {
+        if (!chainFallen[chainHead[point]]) {
+            alive.set(point);
+        }
+    });
+    // The other side cannot make an eye in a region whose every empty point
+    // touches stone
+    for (int region = 0; region < regions; ++region) {
+        if (!regionFallen[region] && enclosed[region] && edgeBegin[region + 1] > edgeBegin[region]) {
+            for (int i = regionBegin[region]; i < regionBegin[region + 1]; ++i) {
+                territory.set(regionPoints[i]);
+            }
+        }
     }
+}
 
-    // Recursively check adjacent positions
-    countLibertiesHelper(x + 1, y, stone, visited, liberties);
-    countLibertiesHelper(x - 1, y, stone, visited, liberties);
-    countLibertiesHelper(x, y + 1, stone, visited, liberties);
-    countLibertiesHelper(x, y - 1, stone, visited, liberties);
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::Bits BasicGoEngine<N, MAX_N>::passAlive(Stone stone) const {
+    Bits chains;
+    Bits territory;
+    if (stone == BLACK || stone == WHITE) {
+        benson(stone, chains, territory);
+    }
+    return chains | territory;
 }
 
-void GoEngine::passTurn(Stone stone) {
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::inSimpleSeki(int head, int other) const {
+    if (chains[head].liberties != 2 || chains[other].liberties != 2) {
+        return false;
+    }
+
+    // Each liberty is shared or an eye of the chain's own; a liberty next
+    // to several stones is simply checked again
+    bool shared = false;
+    for (int chain : {head, other}) {
+        int rest = chain == head ? other : head;
+        int stone = chain;
+        do {
+            const int directions[] = {1, -1, stride, -stride};
+            for (int dir : directions) {
+                int liberty = stone + dir;
+                if (board[liberty] != EMPTY) {
+                    continue;
+                }
+                if (isLibertyOf(liberty, rest)) {
+                    shared = true;
+                    continue;
+                }
+                for (int side : directions) {
+                    if (board[liberty + side] != OFFBOARD && chainHead[liberty + side] != chain) {
+                        return false;
+                    }
+                }
+            }
+            stone = nextStone[stone];
+        } while (stone != chain);
+    }
+    return shared;
+}
+
+template <int N, int MAX_N>
+typename BasicGoEngine<N, MAX_N>::Ownership BasicGoEngine<N, MAX_N>::finalOwnership() const {
+    Ownership result;
+    Bits chains[3];
+    Bits territory[3];
+    benson(BLACK, chains[BLACK], territory[BLACK]);
+    benson(WHITE, chains[WHITE], territory[WHITE]);
+    result.passAlive = chains[BLACK] | chains[WHITE] | territory[BLACK] | territory[WHITE];
+    result.dead = (territory[BLACK] & stoneBits[WHITE]) | (territory[WHITE] & stoneBits[BLACK]);
+
+    // Seki only among the chains nothing has settled
+    Bits settled = result.passAlive | result.dead;
+    stoneBits[BLACK].forEach([&](int point) {
+        if (chainHead[point] != point || settled.test(point)) {
+            return;
+        }
+        int stone = point;
+        do {
+            int heads[4];
+            for (int i = 0, count = adjacentChains(stone, heads); i < count; ++i) {
+                if (board[heads[i]] == WHITE && !settled.test(heads[i]) && inSimpleSeki(point, heads[i])) {
+                    for (int head : {point, heads[i]}) {
+                        auto [x, y] = getCoordinates(head);
+                        result.seki = result.seki | getGroup(x, y);
+                    }
+                }
+            }
+            stone = nextStone[stone];
+        } while (stone != point);
+    });
+    (result.seki.dilate(stride) & stoneBits[EMPTY]).forEach([&](int point) {
+        int heads[4];
+        int count = adjacentChains(point, heads);
+        bool black = false;
+        bool white = false;
+        for (int i = 0; i < count; ++i) {
+            black = black || (board[heads[i]] == BLACK && result.seki.test(heads[i]));
+            white = white || (board[heads[i]] == WHITE && result.seki.test(heads[i]));
+        }
+        if (black && white) {
+            result.seki.set(point);
+        }
+    });
+
+    // Tromp-Taylor with the dead stones lifted; seki liberties touch both
+    // colors, so they stay neutral
+    Bits open = stoneBits[EMPTY] | result.dead;
+    Bits stones[3] = {Bits(), stoneBits[BLACK] ^ (stoneBits[BLACK] & result.dead),
+                      stoneBits[WHITE] ^ (stoneBits[WHITE] & result.dead)};
+    auto reach = [&](const Bits& from) {
+        Bits area = from;
+        for (;;) {
+            Bits grown = (area.dilate(stride) & open) | from;
+            if (grown == area) {
+                return area;
+            }
+            area = grown;
+        }
+    };
+    Bits blackReach = reach(stones[BLACK]);
+    Bits whiteReach = reach(stones[WHITE]);
+    Bits shared = blackReach & whiteReach;
+    result.blackArea = (blackReach ^ shared) | chains[BLACK] | territory[BLACK];
+    result.whiteArea = (whiteReach ^ shared) | chains[WHITE] | territory[WHITE];
+    return result;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::passTurn(Stone stone) {
+    hash ^= stateKey();
     lastPlayer = stone;
-    lastMove = {-1, -1};
+    koPoint = 0;
+    recentMoves[moveNumber++ % MOVE_HISTORY] = PASS;
+    hash ^= stateKey();
+
+    if (koRule == SITUATIONAL_SUPERKO) {
+        history.insert(superkoKey(hash ^ stateKey(), stone));
+    }
 }
 
-void GoEngine::printBoard(std::string title) const {
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::doMove(int x, int y, Stone stone) {
+    if (!isValidMove(x, y, stone)) {
+        return false;
+    }
+
+    undoStack.emplace_back();
+    play(toIndex(x, y), stone, &undoStack.back());
+    return true;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::undoMove() {
+    const UndoRecord& undo = undoStack.back();
+    if (koRule != SIMPLE_KO) {
+        history.erase(superkoKey(hash ^ stateKey(), lastPlayer));
+    }
+
+    // Put the captured chains back; they were left without liberties
+    Stone opponent = board[undo.point] == BLACK ? WHITE : BLACK;
+    const int* captured = undoStones.data() + undo.capturedBegin;
+    for (int i = 0; i < undo.capturedChains; ++i) {
+        int size = *captured++;
+        restoreGroup(captured, size, opponent);
+        captured += size;
+    }
+
+    // Split the joined chains in reverse order; splicing a ring is its own inverse
+    for (int i = undo.mergeCount - 1; i >= 0; --i) {
+        const MergeRecord& merge = undo.merges[i];
+        std::swap(nextStone[merge.survivor], nextStone[merge.absorbed]);
+        int stone = merge.absorbed;
+        do {
+            chainHead[stone] = merge.absorbed;
+            stone = nextStone[stone];
+        } while (stone != merge.absorbed);
+        chains[merge.survivor] = merge.survivorBefore;
+        chains[merge.absorbed] = merge.absorbedBefore;
+    }
+
+    takeBackStone(undo.point);
+    lastPlayer = undo.lastPlayer;
+    koPoint = undo.koPoint;
+    recentMoves[--moveNumber % MOVE_HISTORY] = undo.evictedMove;
+    hash = undo.hash;
+
+    undoStones.resize(undo.capturedBegin);
+    undoStack.pop_back();
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::doPass(Stone stone) {
+    UndoRecord& undo = undoStack.emplace_back();
+    undo.point = 0;
+    undo.lastPlayer = lastPlayer;
+    undo.koPoint = koPoint;
+    undo.hash = hash;
+    undo.capturedBegin = static_cast<int>(undoStones.size());
+    undo.capturedChains = 0;
+    undo.mergeCount = 0;
+    undo.evictedMove = recentMoves[moveNumber % MOVE_HISTORY];
+    passTurn(stone);
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::undoPass() {
+    const UndoRecord& undo = undoStack.back();
+    if (koRule == SITUATIONAL_SUPERKO) {
+        history.erase(superkoKey(hash ^ stateKey(), lastPlayer));
+    }
+
+    lastPlayer = undo.lastPlayer;
+    koPoint = undo.koPoint;
+    recentMoves[--moveNumber % MOVE_HISTORY] = undo.evictedMove;
+    hash = undo.hash;
+    undoStack.pop_back();
+}
+
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::getRecentMove(int ago) const {
+    if (ago < 0 || ago >= MOVE_HISTORY || ago >= moveNumber) {
+        return -1;
+    }
+    return recentMoves[(moveNumber - 1 - ago) % MOVE_HISTORY];
+}
+
+template <int N, int MAX_N>
+uint64_t BasicGoEngine<N, MAX_N>::getHash() const {
+    return hash;
+}
+
+template <int N, int MAX_N>
+BasicGoEngine<N, MAX_N> BasicGoEngine<N, MAX_N>::transformed(Symmetry s) const {
+    const SymmetryTable& table = SymmetryTable::forSize(boardSize);
+    BasicGoEngine result(boardSize);
+
+    // Chains are rebuilt as the stones go down; a legal position has no
+    // chain without liberties, so no order of placement captures anything
+    for (Stone color : {BLACK, WHITE}) {
+        stoneBits[color].forEach([&](int point) { result.addStone(table.transformPoint(s, point), color, nullptr); });
+    }
+
+    result.lastPlayer = lastPlayer;
+    result.koPoint = table.transformPoint(s, koPoint);
+    for (int i = 0; i < MOVE_HISTORY; ++i) {
+        result.recentMoves[i] = table.transformPoint(s, recentMoves[i]);
+    }
+    result.moveNumber = moveNumber;
+    result.hash ^= result.stateKey();
+    result.setKoRule(koRule);
+    return result;
+}
+
+template <int N, int MAX_N>
+uint64_t BasicGoEngine<N, MAX_N>::getHash(Symmetry s) const {
+    const SymmetryTable& table = SymmetryTable::forSize(boardSize);
+    uint64_t result = ZOBRIST.lastPlayer[lastPlayer] ^ table.symmetricKeys(koPoint, EMPTY)[s];
+    for (Stone color : {BLACK, WHITE}) {
+        stoneBits[color].forEach([&](int point) { result ^= table.symmetricKeys(point, color)[s]; });
+    }
+    return result;
+}
+
+template <int N, int MAX_N>
+uint64_t BasicGoEngine<N, MAX_N>::canonicalHash() const {
+    // One pass over the stones updates all 8 hashes together
+    const SymmetryTable& table = SymmetryTable::forSize(boardSize);
+    uint64_t hashes[SYMMETRIES];
+    const uint64_t* ko = table.symmetricKeys(koPoint, EMPTY);
+    for (int s = 0; s < SYMMETRIES; ++s) {
+        hashes[s] = ZOBRIST.lastPlayer[lastPlayer] ^ ko[s];
+    }
+    for (Stone color : {BLACK, WHITE}) {
+        stoneBits[color].forEach([&](int point) {
+            const uint64_t* keys = table.symmetricKeys(point, color);
+            for (int s = 0; s < SYMMETRIES; ++s) {
+                hashes[s] ^= keys[s];
+            }
+        });
+    }
+    return *std::min_element(hashes, hashes + SYMMETRIES);
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::setKoRule(KoRule rule) {
+    // History starts from the current position; earlier ones are not known
+    koRule = rule;
+    history.clear();
+    if (koRule != SIMPLE_KO) {
+        history.insert(superkoKey(hash ^ stateKey(), lastPlayer));
+    }
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::restore(const Snapshot& snapshot) {
+    if (snapshot.size != boardSize) {
+        throw std::invalid_argument("Snapshot is of a " + std::to_string(snapshot.size) + "x" +
+                                    std::to_string(snapshot.size) + " board");
+    }
+    static_cast<Snapshot&>(*this) = snapshot;
+    undoStack.clear();
+    undoStones.clear();
+    setKoRule(koRule);
+}
+
+template <int N, int MAX_N>
+KoRule BasicGoEngine<N, MAX_N>::getKoRule() const {
+    return koRule;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::printBoard(std::string title) const {
     std::cout << title << ": {" << std::endl;
 
     for (int y = 0; y < boardSize; ++y) {
         for (int x = 0; x < boardSize; ++x) {
-            std::cout << (board[x][y] == EMPTY ? '-' : (board[x][y] == BLACK ? 'B' : 'W')) << " ";
+            Stone stone = board[toIndex(x, y)];
+            std::cout << (stone == EMPTY ? '-' : (stone == BLACK ? 'B' : 'W')) << " ";
         }
         std::cout << std::endl;
     }
     std::cout << "}" << std::endl;
 }
 
-void GoEngine::captureStones(int x, int y, Stone stone) {
-    // Temporarily place the stone on the board
-    board[x][y] = stone;
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::play(int point, Stone stone, UndoRecord* undo, MoveDelta* delta) {
+    if (undo) {
+        undo->point = point;
+        undo->lastPlayer = lastPlayer;
+        undo->koPoint = koPoint;
+        undo->hash = hash;
+        undo->capturedBegin = static_cast<int>(undoStones.size());
+        undo->capturedChains = 0;
+        undo->mergeCount = 0;
+        undo->evictedMove = recentMoves[moveNumber % MOVE_HISTORY];
+    }
+
+    hash ^= stateKey();
+    addStone(point, stone, undo);
+    int capturedPoint = 0;
+    int captured = captureStones(point, stone, capturedPoint, undo, delta);
+
+    // A lone stone that took a lone stone and is left with that point as its
+    // only liberty could be taken straight back, repeating the position
+    const Chain& chain = chains[chainHead[point]];
+    koPoint = (captured == 1 && chain.size == 1 && chain.liberties == 1) ? capturedPoint : 0;
+    if (delta) {
+        delta->point = point;
+        delta->stone = stone;
+        delta->koPoint = koPoint;
+    }
+    lastPlayer = stone;
+    recentMoves[moveNumber++ % MOVE_HISTORY] = point;
+    hash ^= stateKey();
+
+    if (koRule != SIMPLE_KO) {
+        history.insert(superkoKey(hash ^ stateKey(), stone));
+    }
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::addStone(int point, Stone stone, UndoRecord* undo) {
+    board[point] = stone;
+    hash ^= ZOBRIST.stones[point][stone];
+    stoneBits[EMPTY].reset(point);
+    stoneBits[stone].set(point);
+    updatePatterns(point, stone);
+    chainHead[point] = point;
+    nextStone[point] = point;
+    chains[point] = Chain{1, 0};
+
+    const int directions[] = {1, -1, stride, -stride};
+    for (int dir : directions) {
+        if (board[point + dir] == EMPTY) {
+            chains[point].liberties++;
+        }
+    }
+
+    // The point stops being a liberty of every chain it touches
+    int touched[4];
+    int touchedCount = adjacentChains(point, touched);
+    for (int i = 0; i < touchedCount; ++i) {
+        chains[touched[i]].liberties--;
+    }
 
-    // Check adjacent positions for opponent stones
-    std::vector<std::pair<int, int>> directions = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-    for (const auto& dir : directions) {
-        int nx = x + dir.first;
-        int ny = y + dir.second;
+    for (int i = 0; i < touchedCount; ++i) {
+        if (board[touched[i]] == stone) {
+            mergeChains(chainHead[point], touched[i], undo);
+        }
+    }
+}
 
-        if (nx >= 0 && nx < boardSize && ny >= 0 && ny < boardSize && board[nx][ny] != EMPTY && board[nx][ny] != stone) {
-            std::vector<std::vector<bool>> visited(boardSize, std::vector<bool>(boardSize, false));
-            if (countLiberties(nx, ny, board[nx][ny]) == 0) {
-                removeGroup(nx, ny, board[nx][ny]);
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::mergeChains(int first, int second, UndoRecord* undo) {
+    // Relabel the smaller chain so the cost is proportional to its size
+    if (chains[first].size < chains[second].size) {
+        std::swap(first, second);
+    }
+
+    if (undo) {
+        undo->merges[undo->mergeCount++] = MergeRecord{first, second, chains[first], chains[second]};
+    }
+
+    // Liberties of the absorbed chain that the surviving chain does not already have
+    unsigned mark = nextMark();
+    int added = 0;
+    int stone = second;
+    do {
+        const int directions[] = {1, -1, stride, -stride};
+        for (int dir : directions) {
+            int neighbor = stone + dir;
+            if (board[neighbor] == EMPTY && marks[neighbor] != mark) {
+                marks[neighbor] = mark;
+                if (!isLibertyOf(neighbor, first)) {
+                    added++;
+                }
             }
         }
+        stone = nextStone[stone];
+    } while (stone != second);
+
+    do {
+        chainHead[stone] = first;
+        stone = nextStone[stone];
+    } while (stone != second);
+
+    // Splice the two circular lists together
+    std::swap(nextStone[first], nextStone[second]);
+    chains[first].size += chains[second].size;
+    chains[first].liberties += added;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::updatePatterns(int point, int digit) {
+    // Off-board neighbors have no weights, so writing to them is harmless
+    const int offsets[PatternTable::NEIGHBORS] = {-stride, 1,          stride,     -1,
+                                                  1 - stride, 1 + stride, stride - 1, -stride - 1};
+    const uint16_t* spread = patternTable->spread(point);
+    for (int d = 0; d < PatternTable::NEIGHBORS; ++d) {
+        patterns[point + offsets[d]] += digit * spread[d];
     }
+}
 
-    // Check if the newly placed stone's group has zero liberties (self-capture)
-    std::vector<std::vector<bool>> visited(boardSize, std::vector<bool>(boardSize, false));
-    if (countLiberties(x, y, stone) == 0) {
-        removeGroup(x, y, stone);
+template <int N, int MAX_N>
+uint16_t BasicGoEngine<N, MAX_N>::getPattern(int point) const {
+    // An orthogonal neighbor in atari has its color's digit raised by 2
+    const int offsets[4] = {-stride, 1, stride, -1};
+    uint16_t code = patterns[point];
+    for (int d = 0; d < 4; ++d) {
+        int neighbor = point + offsets[d];
+        if ((board[neighbor] == BLACK || board[neighbor] == WHITE) && chains[chainHead[neighbor]].liberties == 1) {
+            code += 2 * patternTable->weight(point, d);
+        }
     }
+    return code;
 }
 
-void GoEngine::removeGroup(int x, int y, Stone stone) {
-    if (x < 0 || x >= boardSize || y < 0 || y >= boardSize || board[x][y] != stone) {
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::isLibertyOf(int point, int head) const {
+    return chainHead[point + 1] == head || chainHead[point - 1] == head ||
+           chainHead[point + stride] == head || chainHead[point - stride] == head;
+}
+
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::captureStones(int point, Stone stone, int& capturedPoint, UndoRecord* undo,
+                                           MoveDelta* delta) {
+    // Check adjacent positions for opponent chains left without liberties
+    int captured = 0;
+    const int directions[] = {1, -1, stride, -stride};
+    for (int dir : directions) {
+        int neighbor = point + dir;
+        Stone other = board[neighbor];
+
+        if (other != EMPTY && other != OFFBOARD && other != stone && chains[chainHead[neighbor]].liberties == 0) {
+            capturedPoint = chainHead[neighbor];
+            if (undo) {
+                undoStones.push_back(chains[capturedPoint].size);
+                int stone = capturedPoint;
+                do {
+                    undoStones.push_back(stone);
+                    stone = nextStone[stone];
+                } while (stone != capturedPoint);
+                undo->capturedChains++;
+            }
+            if (delta) {
+                int stone = capturedPoint;
+                do {
+                    delta->captured.push_back(stone);
+                    stone = nextStone[stone];
+                } while (stone != capturedPoint);
+                delta->chainEnds[delta->chainCount++] = delta->captured.size();
+            }
+            captured += removeGroup(capturedPoint);
+        }
+    }
+    return captured;
+}
+
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::removeGroup(int head) {
+    Stone color = board[head];
+    int size = chains[head].size;
+    int stone = head;
+    do {
+        int next = nextStone[stone];
+        board[stone] = EMPTY;
+        hash ^= ZOBRIST.stones[stone][color];
+        stoneBits[color].reset(stone);
+        stoneBits[EMPTY].set(stone);
+        updatePatterns(stone, -color);
+        chainHead[stone] = 0;
+
+        // Each neighboring chain gains this point as a liberty
+        int touched[4];
+        int touchedCount = adjacentChains(stone, touched);
+        for (int i = 0; i < touchedCount; ++i) {
+            if (touched[i] != head) {
+                chains[touched[i]].liberties++;
+            }
+        }
+
+        stone = next;
+    } while (stone != head);
+    return size;
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::restoreGroup(const int* stones, int size, Stone color) {
+    // Rebuild the chain in its original order with the first stone as head
+    int head = stones[0];
+    for (int i = 0; i < size; ++i) {
+        int stone = stones[i];
+        board[stone] = color;
+        hash ^= ZOBRIST.stones[stone][color];
+        stoneBits[EMPTY].reset(stone);
+        stoneBits[color].set(stone);
+        updatePatterns(stone, color);
+        chainHead[stone] = head;
+        nextStone[stone] = stones[(i + 1) % size];
+
+        // Each neighboring chain loses this point as a liberty
+        int touched[4];
+        int touchedCount = adjacentChains(stone, touched);
+        for (int j = 0; j < touchedCount; ++j) {
+            if (touched[j] != head) {
+                chains[touched[j]].liberties--;
+            }
+        }
+    }
+
+    // A captured chain had no liberties left
+    chains[head] = Chain{static_cast<int16_t>(size), 0};
+}
+
+template <int N, int MAX_N>
+void BasicGoEngine<N, MAX_N>::takeBackStone(int point) {
+    Stone color = board[point];
+    board[point] = EMPTY;
+    hash ^= ZOBRIST.stones[point][color];
+    stoneBits[color].reset(point);
+    stoneBits[EMPTY].set(point);
+    updatePatterns(point, -color);
+    chainHead[point] = 0;
+
+    int touched[4];
+    int touchedCount = adjacentChains(point, touched);
+    for (int i = 0; i < touchedCount; ++i) {
+        chains[touched[i]].liberties++;
+    }
+}
+
+template <int N, int MAX_N>
+int BasicGoEngine<N, MAX_N>::adjacentChains(int point, int heads[4]) const {
+    int count = 0;
+    const int directions[] = {1, -1, stride, -stride};
+    for (int dir : directions) {
+        int head = chainHead[point + dir];
+        if (head == 0) {
+            continue;
+        }
+
+        bool seen = false;
+        for (int i = 0; i < count; ++i) {
+            seen = seen || heads[i] == head;
+        }
+        if (!seen) {
+            heads[count++] = head;
+        }
+    }
+    return count;
+}
+
+template <int N, int MAX_N>
+uint64_t BasicGoEngine<N, MAX_N>::stateKey() const {
+    return ZOBRIST.ko[koPoint] ^ ZOBRIST.lastPlayer[lastPlayer];
+}
+
+template <int N, int MAX_N>
+uint64_t BasicGoEngine<N, MAX_N>::superkoKey(uint64_t stonesHash, Stone mover) const {
+    return koRule == SITUATIONAL_SUPERKO ? stonesHash ^ ZOBRIST.lastPlayer[mover] : stonesHash;
+}
+
+template <int N, int MAX_N>
+bool BasicGoEngine<N, MAX_N>::repeatsPosition(int point, Stone stone) const {
+    // Hash of the stones after the move, including the chains it would capture
+    uint64_t stonesHash = hash ^ stateKey() ^ ZOBRIST.stones[point][stone];
+    Stone opponent = stone == BLACK ? WHITE : BLACK;
+
+    int touched[4];
+    int touchedCount = adjacentChains(point, touched);
+    for (int i = 0; i < touchedCount; ++i) {
+        int head = touched[i];
+        if (board[head] != opponent || chains[head].liberties != 1) {
+            continue;
+        }
+
+        int captured = head;
+        do {
+            stonesHash ^= ZOBRIST.stones[captured][opponent];
+            captured = nextStone[captured];
+        } while (captured != head);
+    }
+
+    return history.contains(superkoKey(stonesHash, stone));
+}
+
+PositionHistory::PositionHistory() : slots(64, Entry{0, 0}), used(0) {}
+
+void PositionHistory::insert(uint64_t key) {
+    if ((used + 1) * 2 > slots.size()) {
+        grow();
+    }
+
+    Entry& entry = slots[slotFor(key)];
+    if (entry.count == 0) {
+        entry.key = key;
+        used++;
+    }
+    entry.count++;
+}
+
+void PositionHistory::erase(uint64_t key) {
+    size_t slot = slotFor(key);
+    if (slots[slot].count == 0 || --slots[slot].count != 0) {
         return;
     }
 
-    board[x][y] = EMPTY;
+    // Backward-shift deletion: pull later entries of the probe run into the
+    // hole unless that would move them in front of their home slot
+    used--;
+    size_t mask = slots.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots[next].count != 0; next = (next + 1) & mask) {
+        size_t home = slots[next].key & mask;
+        bool staysPut = hole < next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!staysPut) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = Entry{0, 0};
+}
 
-    removeGroup(x + 1, y, stone);
-    removeGroup(x - 1, y, stone);
-    removeGroup(x, y + 1, stone);
-    removeGroup(x, y - 1, stone);
-}
\ No newline at end of file
+bool PositionHistory::contains(uint64_t key) const {
+    return slots[slotFor(key)].count != 0;
+}
+
+void PositionHistory::clear() {
+    std::fill(slots.begin(), slots.end(), Entry{0, 0});
+    used = 0;
+}
+
+size_t PositionHistory::slotFor(uint64_t key) const {
+    // Zobrist hashes are uniformly distributed, so the low bits make a fine index
+    size_t mask = slots.size() - 1;
+    size_t slot = key & mask;
+    while (slots[slot].count != 0 && slots[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void PositionHistory::grow() {
+    std::vector<Entry> old(slots.size() * 2, Entry{0, 0});
+    old.swap(slots);
+    for (const Entry& entry : old) {
+        if (entry.count != 0) {
+            slots[slotFor(entry.key)] = entry;
+        }
+    }
+}
+
+template <int N, int MAX_N>
+unsigned BasicGoEngine<N, MAX_N>::nextMark() {
+    if (++markGeneration == 0) {
+        std::fill(marks.begin(), marks.end(), 0);
+        markGeneration = 1;
+    }
+    return markGeneration;
+}
+
+template class BasicGoEngine<0>;
+template class BasicGoEngine<0, MAX_BOARD_SIZE>;
+template class BasicGoEngine<9>;
+template class BasicGoEngine<13>;
+template class BasicGoEngine<19>;
+
+GoEngine::Variant GoEngine::makeEngine(int size) {
+    if (size < 1 || size > MAX_BOARD_SIZE) {
+        throw std::invalid_argument("Board size must be between 1 and " + std::to_string(MAX_BOARD_SIZE));
+    }
+
+    switch (size) {
+        case 9:
+            return Variant(std::in_place_type<BasicGoEngine<9>>);
+        case 13:
+            return Variant(std::in_place_type<BasicGoEngine<13>>);
+        case 19:
+            return Variant(std::in_place_type<BasicGoEngine<19>>);
+        default:
+            if (size <= MAX_STANDARD_SIZE) {
+                return Variant(std::in_place_type<BasicGoEngine<0>>, size);
+            }
+            return Boxed<LargeEngine>(new LargeEngine(size));
+    }
+}
+
+GoEngine::GoEngine(int size) : stride(size + 2), engine(makeEngine(size)) {}
+
+int GoEngine::getBoardSize() const {
+    return visit([](const auto& e) { return e.getBoardSize(); });
+}
+
+Stone GoEngine::getStoneAt(int x, int y) const {
+    return visit([&](const auto& e) { return e.getStoneAt(x, y); });
+}
+
+bool GoEngine::placeStone(int x, int y, Stone stone) {
+    if (observer.callback) {
+        int size = getBoardSize();
+        return x >= 0 && x < size && y >= 0 && y < size && placeStone(getPoint(x, y), stone);
+    }
+    return visit([&](auto& e) { return e.placeStone(x, y, stone); });
+}
+
+bool GoEngine::isValidMove(int x, int y, Stone stone) const {
+    return visit([&](const auto& e) { return e.isValidMove(x, y, stone); });
+}
+
+Stone GoEngine::getPlayerToMove() const {
+    return visit([](const auto& e) { return e.getPlayerToMove(); });
+}
+
+void GoEngine::generateLegalMoves(MoveList& moves) const {
+    visit([&](const auto& e) { e.generateLegalMoves(moves); });
+}
+
+void GoEngine::generateLegalMoves(MoveList& moves, Stone stone) const {
+    visit([&](const auto& e) { e.generateLegalMoves(moves, stone); });
+}
+
+Bitboard GoEngine::legalMask(Stone stone) const {
+    return visit([&](const auto& e) -> Bitboard { return e.legalMask(stone); });
+}
+
+Stone GoEngine::getStoneAt(int point) const {
+    return visit([&](const auto& e) { return e.getStoneAt(point); });
+}
+
+Bitboard GoEngine::getStones(Stone stone) const {
+    return visit([&](const auto& e) -> Bitboard { return e.getStones(stone); });
+}
+
+bool GoEngine::placeStone(int point, Stone stone) {
+    if (observer.callback) {
+        return placeObserved(point, stone);
+    }
+    return visit([&](auto& e) { return e.placeStone(point, stone); });
+}
+
+// Out of line, so only observed moves pay for the MoveDelta on the stack
+__attribute__((noinline)) bool GoEngine::placeObserved(int point, Stone stone) {
+    MoveDelta delta;
+    return placeStone(point, stone, delta);
+}
+
+bool GoEngine::placeStone(int point, Stone stone, MoveDelta& delta) {
+    bool played = visit([&](auto& e) { return e.placeStone(point, stone, delta); });
+    if (played && observer.callback) {
+        observer.callback(delta);
+    }
+    return played;
+}
+
+GoEngine GoEngine::transformed(Symmetry s) const {
+    return visit([&](const auto& e) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(e)>, LargeEngine>) {
+            return GoEngine(stride, Boxed<LargeEngine>(new LargeEngine(e.transformed(s))));
+        } else {
+            return GoEngine(stride, Variant(e.transformed(s)));
+        }
+    });
+}
+
+uint64_t GoEngine::getHash(Symmetry s) const {
+    return visit([&](const auto& e) { return e.getHash(s); });
+}
+
+uint64_t GoEngine::canonicalHash() const {
+    return visit([&](const auto& e) { return e.canonicalHash(); });
+}
+
+GoEngine::Snapshot GoEngine::snapshot() const {
+    return visit([](const auto& e) -> Snapshot { return e.share(); });
+}
+
+void GoEngine::restore(const Snapshot& snapshot) {
+    visit([&](auto& e) {
+        using Shared = typename std::decay_t<decltype(e)>::SharedSnapshot;
+        const Shared* shared = std::get_if<Shared>(&snapshot);
+        if (!shared || !*shared) {
+            throw std::invalid_argument("Snapshot is of another board size");
+        }
+        e.restore(**shared);
+    });
+}
+
+int GoEngine::countLiberties(int point) const {
+    return visit([&](const auto& e) { return e.countLiberties(point); });
+}
+
+uint16_t GoEngine::getPattern(int point) const {
+    return visit([&](const auto& e) { return e.getPattern(point); });
+}
+
+int GoEngine::getKoPoint() const {
+    return visit([&](const auto& e) { return e.getKoPoint(); });
+}
+
+int GoEngine::getRecentMove(int ago) const {
+    return visit([&](const auto& e) { return e.getRecentMove(ago); });
+}
+
+bool GoEngine::isTrueEye(int point, Stone stone) const {
+    return visit([&](const auto& e) { return e.isTrueEye(point, stone); });
+}
+
+int GoEngine::countLiberties(int x, int y, Stone stone) const {
+    return visit([&](const auto& e) { return e.countLiberties(x, y, stone); });
+}
+
+Bitboard GoEngine::getGroup(int x, int y) const {
+    return visit([&](const auto& e) -> Bitboard { return e.getGroup(x, y); });
+}
+
+Bitboard GoEngine::getLiberties(int x, int y) const {
+    return visit([&](const auto& e) -> Bitboard { return e.getLiberties(x, y); });
+}
+
+void GoEngine::passTurn(Stone stone) {
+    visit([&](auto& e) { e.passTurn(stone); });
+    if (observer.callback) {
+        passObserved(stone);
+    }
+}
+
+__attribute__((noinline)) void GoEngine::passObserved(Stone stone) {
+    MoveDelta delta;
+    delta.stone = stone;
+    observer.callback(delta);
+}
+
+AreaScore GoEngine::scoreArea(double komi) const {
+    return visit([&](const auto& e) {
+        auto score = e.scoreArea(komi);
+        return AreaScore{score.score, score.black, score.white, score.blackArea, score.whiteArea};
+    });
+}
+
+Bitboard GoEngine::passAlive(Stone stone) const {
+    return visit([&](const auto& e) -> Bitboard { return e.passAlive(stone); });
+}
+
+Ownership GoEngine::finalOwnership() const {
+    return visit([](const auto& e) {
+        auto owned = e.finalOwnership();
+        return Ownership{owned.blackArea, owned.whiteArea, owned.passAlive, owned.dead, owned.seki};
+    });
+}
+
+bool GoEngine::doMove(int x, int y, Stone stone) {
+    return visit([&](auto& e) { return e.doMove(x, y, stone); });
+}
+
+void GoEngine::undoMove() {
+    visit([](auto& e) { e.undoMove(); });
+}
+
+void GoEngine::doPass(Stone stone) {
+    visit([&](auto& e) { e.doPass(stone); });
+}
+
+void GoEngine::undoPass() {
+    visit([](auto& e) { e.undoPass(); });
+}
+
+uint64_t GoEngine::getHash() const {
+    return visit([](const auto& e) { return e.getHash(); });
+}
+
+void GoEngine::setKoRule(KoRule rule) {
+    visit([&](auto& e) { e.setKoRule(rule); });
+}
+
+KoRule GoEngine::getKoRule() const {
+    return visit([](const auto& e) { return e.getKoRule(); });
+}
+
+void GoEngine::printBoard(std::string title) const {
+    visit([&](const auto& e) { e.printBoard(title); });
+}
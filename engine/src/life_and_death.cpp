@@ -0,0 +1,472 @@
+#include "life_and_death.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t INFINITE = 1u << 30;
+constexpr int MAX_PLY = 160;
+constexpr int MAX_MOVES = LifeAndDeathSolver::MAX_REGION + 2;
+constexpr int THREAT = -1;      // a ko threat the opponent answers elsewhere
+
+Stone opponentOf(Stone stone) {
+    return stone == BLACK ? WHITE : BLACK;
+}
+
+uint32_t sum(uint32_t a, uint32_t b) {
+    return std::min(INFINITE, a + b);
+}
+
+struct Bounds {
+    uint32_t proof = 1;
+    uint32_t disproof = 1;
+};
+
+} // namespace
+
+// One reading: can attacker capture the chain at target?
+struct LifeAndDeathSolver::Context {
+    const Bitboard& region;
+    int target;
+    Stone attacker;
+    Stone defender;
+    Stone koWinner;     // the side allowed ko threats
+    uint64_t salt;
+    std::atomic<int64_t>& nodes;
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> next{0};
+    int rootMoves[MAX_MOVES] = {};
+    Outcome outcomes[MAX_MOVES] = {};
+    int rootCount = 0;
+};
+
+template <typename Engine>
+class ProofSearch {
+public:
+    using Context = LifeAndDeathSolver::Context;
+    using Outcome = LifeAndDeathSolver::Outcome;
+
+    ProofSearch(LifeAndDeathSolver& solver, Context& context, Engine& engine)
+        : solver(solver), context(context), engine(engine) {
+        context.region.forEach([&](int point) { region.set(point); });
+        path[0] = key();
+    }
+
+    // Empty region points, then pass and a ko threat where allowed
+    int generateMoves(int* moves) const {
+        int count = 0;
+        (region & engine.getStones(EMPTY)).forEach([&](int point) { moves[count++] = point; });
+        moves[count++] = PASS;
+        int ko = engine.getKoPoint();
+        if (engine.getPlayerToMove() == context.koWinner && threats > 0 && ko != 0 && region.test(ko)) {
+            moves[count++] = THREAT;
+        }
+        return count;
+    }
+
+    bool play(int move) {
+        Stone mover = engine.getPlayerToMove();
+        if (move == PASS) {
+            engine.doPass(mover);
+            savedPasses[ply] = passes++;
+        } else if (move == THREAT) {
+            engine.doPass(mover);
+            engine.doPass(opponentOf(mover));
+            savedPasses[ply] = passes;
+            passes = 0;
+            threats--;
+        } else {
+            auto [x, y] = engine.getCoordinates(move);
+            if (!engine.doMove(x, y, mover)) {
+                return false;
+            }
+            savedPasses[ply] = passes;
+            passes = 0;
+        }
+        path[++ply] = key();
+        return true;
+    }
+
+    void unplay(int move) {
+        passes = savedPasses[--ply];
+        if (move == PASS) {
+            engine.undoPass();
+        } else if (move == THREAT) {
+            engine.undoPass();
+            engine.undoPass();
+            threats++;
+        } else {
+            engine.undoMove();
+        }
+    }
+
+    bool terminal(Bounds& bounds) const {
+        if (engine.getStoneAt(context.target) != context.defender) {
+            bounds = {0, INFINITE};
+            return true;
+        }
+        if (passes >= 2 || ply >= MAX_PLY || hasTwoEyes()) {
+            bounds = {INFINITE, 0};
+            return true;
+        }
+        return false;
+    }
+
+    // Reads the current position to the end, or until the budget runs out
+    Outcome solve() {
+        Bounds bounds;
+        if (!terminal(bounds)) {
+            bounds = search(INFINITE, INFINITE);
+        }
+        return bounds.proof == 0 ? LifeAndDeathSolver::PROVEN
+               : bounds.disproof == 0 ? LifeAndDeathSolver::DISPROVEN
+                                      : LifeAndDeathSolver::OPEN;
+    }
+
+private:
+    LifeAndDeathSolver& solver;
+    Context& context;
+    Engine& engine;
+    typename Engine::Bits region;   // context.region at this engine's width
+    int passes = 0;     // in a row, just before this position
+    int threats = LifeAndDeathSolver::KO_THREATS;
+    int ply = 0;
+    int savedPasses[MAX_PLY + 1];
+    uint64_t path[MAX_PLY + 1];     // keys from the root down
+
+    uint64_t key() const {
+        return engine.getHash() ^ context.salt ^ uint64_t(passes) * 0x9E3779B97F4A7C15ULL ^
+               uint64_t(threats) * 0xC2B2AE3D27D4EB4FULL;
+    }
+
+    bool repeated() const {
+        return std::find(path, path + ply, path[ply]) != path + ply;
+    }
+
+    // Two liberties whose every neighbor is the chain itself can never be
+    // filled by the attacker
+    bool hasTwoEyes() const {
+        auto [x, y] = engine.getCoordinates(context.target);
+        auto group = engine.getGroup(x, y);
+        int stride = engine.getStride();
+        int eyes = 0;
+        engine.getLiberties(x, y).forEach([&](int liberty) {
+            bool eye = true;
+            for (int dir : {1, -1, stride, -stride}) {
+                int neighbor = liberty + dir;
+                eye = eye && (engine.getStoneAt(neighbor) == OFFBOARD || group.test(neighbor));
+            }
+            eyes += eye;
+        });
+        return eyes >= 2;
+    }
+
+    bool countNode() {
+        if (context.nodes.fetch_add(1, std::memory_order_relaxed) >= solver.options.maxNodes) {
+            context.stop.store(true, std::memory_order_relaxed);
+        }
+        return !context.stop.load(std::memory_order_relaxed);
+    }
+
+    // Multiple iterative deepening (MID): expands the current position until
+    // its proof number reaches proofLimit or its disproof number reaches
+    // disproofLimit, storing every position it finishes with
+    Bounds search(uint32_t proofLimit, uint32_t disproofLimit) {
+        if (!countNode()) {
+            return {};
+        }
+
+        // The attacker needs one good move, the defender needs every move answered
+        bool attacking = engine.getPlayerToMove() == context.attacker;
+        int candidates[MAX_MOVES];
+        int moves[MAX_MOVES];
+        Bounds children[MAX_MOVES];
+        int count = 0;
+        for (int i = 0, n = generateMoves(candidates); i < n; ++i) {
+            if (!play(candidates[i])) {
+                continue;
+            }
+            Bounds& child = children[count];
+            if (!terminal(child)) {
+                if (repeated()) {
+                    child = {INFINITE, 0};
+                } else if (!solver.probe(key(), child.proof, child.disproof)) {
+                    child = {};
+                }
+            }
+            unplay(candidates[i]);
+            moves[count++] = candidates[i];
+        }
+
+        Bounds bounds;
+        while (true) {
+            uint32_t best = INFINITE;
+            uint32_t second = INFINITE;
+            uint32_t total = 0;
+            int chosen = 0;
+            for (int i = 0; i < count; ++i) {
+                uint32_t value = attacking ? children[i].proof : children[i].disproof;
+                total = sum(total, attacking ? children[i].disproof : children[i].proof);
+                if (value < best) {
+                    second = best;
+                    best = value;
+                    chosen = i;
+                } else if (value < second) {
+                    second = value;
+                }
+            }
+            bounds = attacking ? Bounds{best, total} : Bounds{total, best};
+            if (bounds.proof >= proofLimit || bounds.disproof >= disproofLimit ||
+                context.stop.load(std::memory_order_relaxed)) {
+                break;
+            }
+
+            Bounds& child = children[chosen];
+            uint32_t childProof, childDisproof;
+            if (attacking) {
+                childProof = std::min(proofLimit, sum(second, 1));
+                childDisproof = disproofLimit - bounds.disproof + child.disproof;
+            } else {
+                childProof = proofLimit - bounds.proof + child.proof;
+                childDisproof = std::min(disproofLimit, sum(second, 1));
+            }
+            play(moves[chosen]);
+            child = search(childProof, childDisproof);
+            unplay(moves[chosen]);
+        }
+
+        if (!context.stop.load(std::memory_order_relaxed)) {
+            solver.store(key(), bounds.proof, bounds.disproof);
+        }
+        return bounds;
+    }
+};
+
+LifeAndDeathSolver::LifeAndDeathSolver(const LifeAndDeathOptions& options) : options(options) {
+    if (this->options.threads <= 0) {
+        this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= options.tableBytes) {
+        count *= 2;
+    }
+    table = std::make_unique<Entry[]>(count);
+    entryCount = count;
+}
+
+bool LifeAndDeathSolver::probe(uint64_t key, uint32_t& proof, uint32_t& disproof) const {
+    const Entry& entry = table[key & (entryCount - 1)];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ data) != key) {
+        return false;
+    }
+    proof = static_cast<uint32_t>(data >> 32);
+    disproof = static_cast<uint32_t>(data);
+    return true;
+}
+
+void LifeAndDeathSolver::store(uint64_t key, uint32_t proof, uint32_t disproof) {
+    Entry& entry = table[key & (entryCount - 1)];
+    uint64_t data = uint64_t(proof) << 32 | disproof;
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+LifeAndDeathSolver::Outcome LifeAndDeathSolver::read(Context& context, const GoEngine& position, Stone toMove,
+                                                     int& keyMove) {
+    keyMove = PASS;
+    auto prepare = [&](GoEngine& engine) {
+        if (engine.getPlayerToMove() != toMove) {
+            engine.doPass(opponentOf(toMove));
+        }
+    };
+
+    // The root is expanded here; each worker then takes root moves one at a time
+    GoEngine root = position;
+    prepare(root);
+    bool settled = root.visit([&](auto& engine) {
+        ProofSearch search(*this, context, engine);
+        Bounds bounds;
+        if (search.terminal(bounds)) {
+            context.outcomes[0] = bounds.proof == 0 ? PROVEN : DISPROVEN;
+            return true;
+        }
+        context.rootCount = search.generateMoves(context.rootMoves);
+        return false;
+    });
+    if (settled) {
+        return context.outcomes[0];
+    }
+
+    bool attacking = toMove == context.attacker;
+    Outcome decisive = attacking ? PROVEN : DISPROVEN;
+    auto work = [&](GoEngine& engine) {
+        engine.visit([&](auto& inner) {
+            ProofSearch search(*this, context, inner);
+            int i;
+            while (!context.stop.load(std::memory_order_relaxed) &&
+                   (i = context.next.fetch_add(1, std::memory_order_relaxed)) < context.rootCount) {
+                int move = context.rootMoves[i];
+                if (!search.play(move)) {
+                    // An illegal move decides nothing either way
+                    context.outcomes[i] = attacking ? DISPROVEN : PROVEN;
+                    continue;
+                }
+                context.outcomes[i] = search.solve();
+                search.unplay(move);
+                if (context.outcomes[i] == decisive) {
+                    context.stop.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    };
+
+    for (int i = 0; i < context.rootCount; ++i) {
+        context.outcomes[i] = OPEN;
+    }
+    std::vector<std::thread> workers;
+    for (int i = 1; i < std::min(options.threads, context.rootCount); ++i) {
+        workers.emplace_back([&, i] {
+            GoEngine engine = position;
+            prepare(engine);
+            work(engine);
+        });
+    }
+    work(root);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    bool open = false;
+    for (int i = 0; i < context.rootCount; ++i) {
+        if (context.outcomes[i] == decisive) {
+            keyMove = context.rootMoves[i];
+            return decisive;
+        }
+        open = open || context.outcomes[i] == OPEN;
+    }
+    return open ? OPEN : attacking ? DISPROVEN : PROVEN;
+}
+
+LifeAndDeath LifeAndDeathSolver::solve(const GoEngine& position, int point, Stone toMove) {
+    return solve(position, point, enclosedRegion(position, point), toMove);
+}
+
+LifeAndDeath LifeAndDeathSolver::solve(const GoEngine& position, int point, const Bitboard& region, Stone toMove) {
+    Stone defender = position.getStoneAt(point);
+    if (defender != BLACK && defender != WHITE) {
+        throw std::invalid_argument("No chain to read at point " + std::to_string(point));
+    }
+    Stone attacker = opponentOf(defender);
+
+    LifeAndDeath result;
+    if (region.count() > MAX_REGION) {
+        return result;
+    }
+
+    std::atomic<int64_t> nodes{0};
+    solves++;
+    auto reading = [&](int target, Stone capturer, Stone koWinner, Stone mover, int& keyMove) {
+        uint64_t salt = (solves * 0x9E3779B97F4A7C15ULL) ^ (uint64_t(target) << 8 | koWinner << 1 | mover);
+        Context context{region, target, capturer, opponentOf(capturer), koWinner, salt * 0xBF58476D1CE4E5B9ULL,
+                        nodes};
+        return read(context, position, mover, keyMove);
+    };
+
+    // Strict first: the side to move must succeed without winning a ko
+    int strictMove;
+    int koMove;
+    Outcome strict = reading(point, attacker, toMove == attacker ? defender : attacker, toMove, strictMove);
+    if (strict == OPEN) {
+        result.nodes = nodes;
+        return result;
+    }
+    if (toMove == attacker && strict == PROVEN) {
+        result.status = DEAD;
+        result.keyMove = strictMove;
+    } else if (toMove == defender && strict == DISPROVEN) {
+        result.status = ALIVE;
+        result.keyMove = strictMove;
+    } else {
+        Outcome ko = reading(point, attacker, toMove, toMove, koMove);
+        if (ko == OPEN) {
+            result.status = UNRESOLVED;
+        } else if (ko == (toMove == attacker ? PROVEN : DISPROVEN)) {
+            result.status = KO;
+            result.keyMove = koMove;
+        } else {
+            result.status = toMove == attacker ? ALIVE : DEAD;
+        }
+    }
+
+    // A living chain that cannot take the enclosed chains it shares
+    // liberties with is in seki
+    if (result.status == ALIVE) {
+        auto [x, y] = position.getCoordinates(point);
+        Bitboard liberties = position.getLiberties(x, y);
+        Bitboard checked;
+        bool shared = false;
+        bool capturable = false;
+        int stride = position.getStride();
+        position.getGroup(x, y).forEach([&](int stone) {
+            for (int dir : {1, -1, stride, -stride}) {
+                int neighbor = stone + dir;
+                if (position.getStoneAt(neighbor) != attacker || checked.test(neighbor) || capturable) {
+                    continue;
+                }
+                auto [nx, ny] = position.getCoordinates(neighbor);
+                Bitboard chain = position.getGroup(nx, ny);
+                Bitboard outside = position.getLiberties(nx, ny);
+                checked = checked | chain;
+                if ((outside & region) != outside || (outside & liberties).empty()) {
+                    continue;
+                }
+                shared = true;
+                int unused;
+                Outcome take = reading(neighbor, defender, attacker, defender, unused);
+                capturable = take != DISPROVEN;
+            }
+        });
+        if (shared && !capturable) {
+            result.status = SEKI;
+        }
+    }
+
+    result.nodes = nodes;
+    return result;
+}
+
+Bitboard enclosedRegion(const GoEngine& position, int point) {
+    Stone defender = position.getStoneAt(point);
+    Bitboard region;
+    if (defender != BLACK && defender != WHITE) {
+        return region;
+    }
+
+    Stone attacker = opponentOf(defender);
+    int stride = position.getStride();
+    Bitboard passable = position.getStones(EMPTY) | position.getStones(defender);
+    auto [x, y] = position.getCoordinates(point);
+    region = position.getGroup(x, y);
+    for (Bitboard grown = region; ; region = grown) {
+        grown = region | (region.dilate(stride) & passable);
+        if (grown == region) {
+            break;
+        }
+    }
+
+    Bitboard inside = region;
+    (region.dilate(stride) & position.getStones(attacker)).forEach([&](int stone) {
+        auto [sx, sy] = position.getCoordinates(stone);
+        Bitboard liberties = position.getLiberties(sx, sy);
+        if ((liberties & region) == liberties) {
+            inside = inside | position.getGroup(sx, sy);
+        }
+    });
+    return inside;
+}
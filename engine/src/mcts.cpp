@@ -0,0 +1,323 @@
+#include "mcts.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "playout.hpp"
+
+struct Mcts::Context {
+    const GoEngine& position;
+    Node* root;
+    SearchBudget budget;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<int64_t> playouts{0};
+    std::atomic<int64_t> completed{0};
+    std::atomic<int64_t> nodes{0};
+    std::atomic<bool> stop{false};
+};
+
+namespace {
+
+Stone opponentOf(Stone stone) {
+    return stone == BLACK ? WHITE : BLACK;
+}
+
+} // namespace
+
+Mcts::Mcts(const SearchOptions& options) : options(options) {
+    if (this->options.threads <= 0) {
+        this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (this->options.memoryBytes != 0) {
+        budgetBytes = std::max(this->options.memoryBytes, 2 * NodeArena::CHUNK_BYTES);
+        arena.setBudget(budgetBytes / 2);
+    }
+}
+
+Mcts::~Mcts() {
+    clear();
+}
+
+void Mcts::clear() {
+    tree.reset();
+    root = nullptr;
+    rootPosition.reset();
+    treeNodes = 0;
+}
+
+SearchResult Mcts::search(const GoEngine& position, const SearchBudget& budget) {
+    bool reuse = root && rootPosition->getBoardSize() == position.getBoardSize() &&
+                 rootPosition->getHash() == position.getHash();
+    if (!reuse) {
+        clear();
+        tree = std::make_unique<NodeArena::Region>(arena);
+        NodeArena::Cursor cursor(*tree);
+        root = cursor.allocate(1);
+        root->player = opponentOf(position.getPlayerToMove());
+        root->hash.store(position.getHash(), std::memory_order_relaxed);
+        rootPosition = position;
+        treeNodes = 1;
+    }
+
+    if (options.transpositions) {
+        options.transpositions->newSearch();
+    }
+
+    Context context{position, root, budget, std::chrono::steady_clock::now()};
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < options.threads; ++i) {
+        workers.emplace_back(&Mcts::runWorker, this, std::ref(context), i);
+    }
+    runWorker(context, 0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    treeNodes += context.nodes.load();
+
+    SearchResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - context.start).count();
+    result.playouts = context.completed.load();
+    result.nodes = treeNodes;
+    result.playoutsPerSecond = result.seconds > 0 ? result.playouts / result.seconds : 0;
+
+    Node* children = root->children.load(std::memory_order_acquire);
+    int bestVisits = -1;
+    for (int i = 0; children && i < root->childCount; ++i) {
+        const Node& child = children[i];
+        int visits = child.visits.load();
+        result.visits.emplace_back(child.move, visits);
+        if (visits > bestVisits) {
+            bestVisits = visits;
+            result.bestMove = child.move;
+            result.winRate = visits > 0 ? child.wins.load() / visits : 0.5;
+        }
+    }
+    return result;
+}
+
+void Mcts::advance(int move) {
+    Node* children = root ? root->children.load(std::memory_order_relaxed) : nullptr;
+    Node* kept = nullptr;
+    for (int i = 0; children && i < root->childCount; ++i) {
+        if (children[i].move == move) {
+            kept = &children[i];
+        }
+    }
+
+    if (!kept) {
+        clear();
+        return;
+    }
+    if (move == PASS) {
+        rootPosition->passTurn(kept->player);
+    } else {
+        rootPosition->placeStone(move, kept->player);
+    }
+
+    // Copy the kept subtree into fresh chunks, in the half of the budget the
+    // search left free, then drop the old tree whole
+    if (budgetBytes != 0) {
+        arena.setBudget(budgetBytes);
+    }
+    auto next = std::make_unique<NodeArena::Region>(arena);
+    NodeArena::Cursor cursor(*next);
+    Node* newRoot = cursor.allocate(1);
+    if (!newRoot) {
+        // No room even for the root; the next search starts a fresh tree
+        next.reset();
+        clear();
+        arena.setBudget(budgetBytes / 2);
+        return;
+    }
+    std::vector<std::pair<const Node*, Node*>> pending{{kept, newRoot}};
+    int64_t copied = 1;
+    while (!pending.empty()) {
+        auto [from, to] = pending.back();
+        pending.pop_back();
+
+        to->move = from->move;
+        to->player = from->player;
+        to->visits.store(from->visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to->wins.store(from->wins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to->hash.store(from->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        const Node* fromChildren = from->children.load(std::memory_order_relaxed);
+        Node* toChildren = fromChildren ? cursor.allocate(from->childCount) : nullptr;
+        if (toChildren) {
+            // Out of budget leaves the copy unexpanded; it grows again on the next visit
+            to->childCount = from->childCount;
+            to->children.store(toChildren, std::memory_order_relaxed);
+            to->state.store(Node::EXPANDED, std::memory_order_relaxed);
+            copied += from->childCount;
+            for (int i = 0; i < from->childCount; ++i) {
+                pending.emplace_back(&fromChildren[i], &toChildren[i]);
+            }
+        }
+    }
+
+    tree = std::move(next);
+    root = newRoot;
+    treeNodes = copied;
+    if (budgetBytes != 0) {
+        arena.setBudget(budgetBytes / 2);
+    }
+}
+
+void Mcts::runWorker(Context& context, int index) {
+    // Dispatch on the board size once; everything below runs on the specialized engine
+    context.position.visit([&](const auto& position) { runIterations(context, position, index); });
+}
+
+template <typename Engine>
+void Mcts::runIterations(Context& context, const Engine& position, int index) {
+    Rng rng(options.seed + 0x9E3779B97F4A7C15ULL * (index + 1));
+    Engine engine = position;   // walked down and back up with doMove/undoMove
+    Engine scratch = position;  // playouts run here, from a snapshot of engine
+    NodeArena::Cursor cursor(*tree);        // this thread's own chunk
+    // Longest line followed through the tree in one descent
+    const int maxDepth = 4 * position.getBoardSize() * position.getBoardSize();
+    std::vector<Node*> path(maxDepth + 1);
+
+    while (!context.stop.load(std::memory_order_relaxed)) {
+        int64_t started = context.playouts.fetch_add(1, std::memory_order_relaxed);
+        if ((context.budget.playouts > 0 && started >= context.budget.playouts) ||
+            (context.budget.seconds > 0 && (started & 15) == 0 &&
+             std::chrono::duration<double>(std::chrono::steady_clock::now() - context.start).count() >= context.budget.seconds)) {
+            context.stop.store(true, std::memory_order_relaxed);
+            break;
+        }
+
+        // Selection: descend, charging virtual loss, until a leaf or the game ends
+        Node* node = context.root;
+        int depth = 0;
+        int passes = 0;
+        path[depth++] = node;
+        while (passes < 2 && depth <= maxDepth) {
+            if (node->state.load(std::memory_order_acquire) != Node::EXPANDED) {
+                // Expand on the second visit; the root is expanded right away
+                bool ready = node == context.root || node->visits.load(std::memory_order_relaxed) > 0;
+                if (!ready || !expand(context, node, engine, cursor)) {
+                    break;
+                }
+            }
+
+            Node* child = selectChild(node);
+            if (child->move == PASS) {
+                engine.doPass(child->player);
+                passes++;
+            } else {
+                auto [x, y] = engine.getCoordinates(child->move);
+                engine.doMove(x, y, child->player);
+                passes = 0;
+            }
+            if (child->hash.load(std::memory_order_relaxed) == 0) {
+                child->hash.store(engine.getHash(), std::memory_order_relaxed);
+            }
+            child->virtualLoss.fetch_add(options.virtualLoss, std::memory_order_relaxed);
+            node = child;
+            path[depth++] = node;
+        }
+
+        // Simulation: finished games are scored as they stand
+        int score;
+        if (passes >= 2) {
+            score = static_cast<int>(engine.scoreArea(0).score);
+        } else {
+            // Only the position is copied; superko history restarts from it
+            scratch.restore(engine.snapshot());
+            score = playout(scratch, rng);
+        }
+        Stone winner = score - options.komi > 0 ? BLACK : WHITE;
+        double draw = score - options.komi == 0 ? 0.5 : -1;
+
+        // Backpropagation, taking the moves and the virtual loss back
+        for (int i = depth - 1; i >= 0; --i) {
+            Node* visited = path[i];
+            double result = draw >= 0 ? draw : (visited->player == winner ? 1.0 : 0.0);
+            visited->wins.fetch_add(result, std::memory_order_relaxed);
+            visited->visits.fetch_add(1, std::memory_order_relaxed);
+            if (options.transpositions) {
+                options.transpositions->add(visited->hash.load(std::memory_order_relaxed), 1, result);
+            }
+            if (i > 0) {
+                visited->virtualLoss.fetch_sub(options.virtualLoss, std::memory_order_relaxed);
+                if (visited->move == PASS) {
+                    engine.undoPass();
+                } else {
+                    engine.undoMove();
+                }
+            }
+        }
+        context.completed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Mcts::Node* Mcts::selectChild(Node* node) const {
+    Node* children = node->children.load(std::memory_order_acquire);
+    int parentVisits = node->visits.load(std::memory_order_relaxed) + node->virtualLoss.load(std::memory_order_relaxed);
+    double logParent = std::log(std::max(1, parentVisits));
+
+    Node* best = &children[0];
+    double bestScore = -1;
+    for (int i = 0; i < node->childCount; ++i) {
+        Node* child = &children[i];
+        int virtualLoss = child->virtualLoss.load(std::memory_order_relaxed);
+        int visits = child->visits.load(std::memory_order_relaxed) + virtualLoss;
+        if (visits == 0) {
+            return child; // every child gets one look before any gets two
+        }
+
+        // Virtual loss counts as visits that were all lost
+        double value = child->wins.load(std::memory_order_relaxed) / visits;
+        uint64_t hash = child->hash.load(std::memory_order_relaxed);
+        PositionStats shared;
+        if (options.transpositions && hash != 0 && options.transpositions->probe(hash, shared) &&
+            static_cast<int>(shared.visits) + virtualLoss > visits) {
+            value = shared.wins / (shared.visits + virtualLoss);
+        }
+        double score = value + options.exploration * std::sqrt(logParent / visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = child;
+        }
+    }
+    return best;
+}
+
+template <typename Engine>
+bool Mcts::expand(Context& context, Node* node, const Engine& engine, NodeArena::Cursor& cursor) {
+    uint8_t expected = Node::LEAF;
+    if (!node->state.compare_exchange_strong(expected, Node::EXPANDING, std::memory_order_acq_rel)) {
+        // Someone else is expanding it; run a playout from here instead of waiting
+        return expected == Node::EXPANDED;
+    }
+
+    MoveList moves;
+    Stone player = opponentOf(node->player);
+    engine.generateLegalMoves(moves, player);
+
+    Node* children = cursor.allocate(moves.size() + 1);
+    if (!children) {
+        // Memory budget spent: the tree stays as it is
+        node->state.store(Node::LEAF, std::memory_order_release);
+        return false;
+    }
+    for (int i = 0; i < moves.size(); ++i) {
+        children[i].move = moves[i];
+        children[i].player = player;
+    }
+    children[moves.size()].move = PASS;
+    children[moves.size()].player = player;
+
+    node->childCount = moves.size() + 1;
+    node->children.store(children, std::memory_order_release);
+    node->state.store(Node::EXPANDED, std::memory_order_release);
+    // Counted here, by the one thread that won the node, not by every caller
+    context.nodes.fetch_add(node->childCount, std::memory_order_relaxed);
+    return true;
+}
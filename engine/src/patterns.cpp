@@ -0,0 +1,44 @@
+#include "patterns.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+void PatternWeights::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        std::string_view text(line);
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos || text[start] == '#') {
+            continue;
+        }
+        text.remove_prefix(start);
+
+        int code = 0;
+        float weight = 0;
+        const char* end = text.data() + text.size();
+        auto [afterCode, codeError] = std::from_chars(text.data(), end, code);
+        const char* weightStart = afterCode;
+        while (weightStart < end && (*weightStart == ' ' || *weightStart == '\t')) {
+            weightStart++;
+        }
+        auto [afterWeight, weightError] = std::from_chars(weightStart, end, weight);
+        while (afterWeight < end && (*afterWeight == ' ' || *afterWeight == '\t' || *afterWeight == '\r')) {
+            afterWeight++;
+        }
+
+        if (codeError != std::errc() || weightStart == afterCode || weightError != std::errc() || afterWeight != end ||
+            code < 0 || code >= PatternTable::CODES) {
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": expected a pattern code and a weight");
+        }
+        weights[code] = weight;
+    }
+}
@@ -0,0 +1,171 @@
+#include "playout.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+constexpr int CHUNK_PLAYOUTS = 16;  // claimed at a time, so stealing stays cheap next to the work
+
+// A worker's run of chunks; the owner and thieves alike take from the front
+struct alignas(64) ChunkQueue {
+    std::atomic<int> next{0};
+    int end = 0;
+
+    int take() {
+        int chunk = next.fetch_add(1, std::memory_order_relaxed);
+        return chunk < end ? chunk : -1;
+    }
+};
+
+// SplitMix64, so neighbouring chunks get unrelated streams
+uint64_t chunkSeed(uint64_t hash, int chunk) {
+    uint64_t z = hash + (uint64_t(chunk) + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+template <int N, int MAX_N>
+void playToEnd(BasicGoEngine<N, MAX_N>& engine, Rng& rng) {
+    const int size = engine.getBoardSize();
+    const int maxMoves = 3 * size * size;
+    int passes = 0;
+
+    for (int move = 0; move < maxMoves && passes < 2; ++move) {
+        Stone stone = engine.getPlayerToMove();
+
+        // Draw candidates without replacement until one is playable
+        auto candidates = engine.getStones(EMPTY);
+        int remaining = candidates.count();
+        bool played = false;
+        while (remaining > 0 && !played) {
+            int point = candidates.nth(rng.below(remaining));
+            candidates.reset(point);
+            remaining--;
+            played = !engine.isTrueEye(point, stone) && engine.placeStone(point, stone);
+        }
+
+        if (played) {
+            passes = 0;
+        } else {
+            engine.passTurn(stone);
+            passes++;
+        }
+    }
+}
+
+} // namespace
+
+template <int N, int MAX_N>
+int playout(BasicGoEngine<N, MAX_N>& engine, Rng& rng) {
+    playToEnd(engine, rng);
+    return static_cast<int>(engine.scoreArea(0).score);
+}
+
+template int playout(BasicGoEngine<0>& engine, Rng& rng);
+template int playout(BasicGoEngine<0, MAX_BOARD_SIZE>& engine, Rng& rng);
+template int playout(BasicGoEngine<9>& engine, Rng& rng);
+template int playout(BasicGoEngine<13>& engine, Rng& rng);
+template int playout(BasicGoEngine<19>& engine, Rng& rng);
+
+int playout(GoEngine& engine, Rng& rng) {
+    return engine.visit([&](auto& inner) { return playout(inner, rng); });
+}
+
+OwnershipEstimate estimateOwnership(const GoEngine& position, int playouts, int threads) {
+    const int size = position.getBoardSize();
+    const int area = size * size;
+    Ownership settled = position.finalOwnership();
+
+    OwnershipEstimate estimate;
+    estimate.size = size;
+    estimate.playouts = std::max(playouts, 0);
+    estimate.ownership.assign(area, 0.0f);
+    estimate.dead = settled.dead;
+    if (playouts <= 0) {
+        return estimate;
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    int chunks = (playouts + CHUNK_PLAYOUTS - 1) / CHUNK_PLAYOUTS;
+    int workers = std::min(threads, chunks);
+    std::vector<ChunkQueue> queues(workers);
+    for (int worker = 0; worker < workers; ++worker) {
+        queues[worker].next.store(chunks * worker / workers, std::memory_order_relaxed);
+        queues[worker].end = chunks * (worker + 1) / workers;
+    }
+    // Black's count minus white's, one row-major array per worker
+    std::vector<std::vector<int>> counts(workers, std::vector<int>(area, 0));
+
+    auto work = [&](int worker) {
+        position.visit([&](const auto& engine) {
+            using Engine = std::decay_t<decltype(engine)>;
+            Engine game = engine;   // each playout starts from a snapshot of engine
+            Rng rng;
+            int* net = counts[worker].data();
+            for (int i = 0; i < workers; ++i) {
+                ChunkQueue& queue = queues[(worker + i) % workers];
+                for (int chunk = queue.take(); chunk >= 0; chunk = queue.take()) {
+                    rng = Rng(chunkSeed(position.getHash(), chunk));
+                    int last = std::min(playouts, (chunk + 1) * CHUNK_PLAYOUTS);
+                    for (int n = chunk * CHUNK_PLAYOUTS; n < last; ++n) {
+                        game.restore(engine.snapshot());
+                        playToEnd(game, rng);
+                        typename Engine::AreaScore score = game.scoreArea(0);
+                        for (int y = 0; y < size; ++y) {
+                            for (int x = 0; x < size; ++x) {
+                                int point = game.getPoint(x, y);
+                                net[y * size + x] += int(score.blackArea.test(point)) - int(score.whiteArea.test(point));
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    };
+    std::vector<std::thread> pool;
+    for (int worker = 1; worker < workers; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    for (const std::vector<int>& net : counts) {
+        for (int i = 0; i < area; ++i) {
+            estimate.ownership[i] += net[i];
+        }
+    }
+    for (float& value : estimate.ownership) {
+        value /= playouts;
+    }
+
+    // Chains live or die together, so each is judged on its mean
+    Bitboard seen = settled.passAlive | settled.dead | settled.seki;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            Stone stone = position.getStoneAt(x, y);
+            if (stone == EMPTY || seen.test(position.getPoint(x, y))) {
+                continue;
+            }
+            Bitboard chain = position.getGroup(x, y);
+            float sum = 0;
+            chain.forEach([&](int point) {
+                auto [cx, cy] = position.getCoordinates(point);
+                sum += estimate.at(cx, cy);
+            });
+            float lean = (stone == BLACK ? sum : -sum) / chain.count();
+            if (lean < -OwnershipEstimate::DEAD_OWNERSHIP) {
+                estimate.dead = estimate.dead | chain;
+            }
+            seen = seen | chain;
+        }
+    }
+    return estimate;
+}
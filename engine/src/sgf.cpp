@@ -0,0 +1,318 @@
+#include "sgf.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+    }
+
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+}
+
+void SgfGame::clear() {
+    size = 19;
+    komi = 0;
+    result = {};
+    setup.clear();
+    moves.clear();
+}
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// SGF writes a coordinate as a letter: a-z for 0-25, A-Z for 26-51
+int coordinate(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 26;
+    }
+    return -1;
+}
+
+} // namespace
+
+bool SgfReader::next(SgfGame& game) {
+    game.clear();
+
+    // Anything before the first '(' is ignored, as the format allows
+    const void* open = pos < text.size() ? std::memchr(text.data() + pos, '(', text.size() - pos) : nullptr;
+    if (!open) {
+        pos = text.size();
+        return false;
+    }
+    pos = static_cast<const char*>(open) - text.data() + 1;
+
+    // Follow the first variation down; once it closes, every later
+    // variation at any level is a sibling of the main line and is skipped
+    int depth = 1;
+    bool root = true;
+    bool mainLineDone = false;
+    while (depth > 0) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            fail("Unterminated game tree");
+        }
+
+        char c = text[pos];
+        if (c == ';') {
+            pos++;
+            if (mainLineDone) {
+                fail("Node after a variation");
+            }
+            readNode(game, root);
+            root = false;
+        } else if (c == '(') {
+            if (root) {
+                fail("Game tree without nodes");
+            }
+            if (mainLineDone) {
+                skipTree();
+            } else {
+                pos++;
+                depth++;
+            }
+        } else if (c == ')') {
+            if (root) {
+                fail("Game tree without nodes");
+            }
+            pos++;
+            depth--;
+            mainLineDone = true;
+        } else {
+            fail("Unexpected character");
+        }
+    }
+    return true;
+}
+
+void SgfReader::skipWhitespace() {
+    while (pos < text.size() && isSpace(text[pos])) {
+        pos++;
+    }
+}
+
+std::string_view SgfReader::readValue() {
+    // pos is just past '['; the value ends at the first unescaped ']'
+    size_t begin = pos;
+    for (;;) {
+        const void* close = std::memchr(text.data() + pos, ']', text.size() - pos);
+        if (!close) {
+            pos = begin;
+            fail("Unterminated property value");
+        }
+        size_t end = static_cast<const char*>(close) - text.data();
+
+        size_t backslashes = 0;
+        while (end - backslashes > begin && text[end - backslashes - 1] == '\\') {
+            backslashes++;
+        }
+        pos = end + 1;
+        if (backslashes % 2 == 0) {
+            return text.substr(begin, end - begin);
+        }
+    }
+}
+
+void SgfReader::readNode(SgfGame& game, bool root) {
+    for (;;) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return;
+        }
+
+        // Identifiers are upper case; old files mix in lower-case letters,
+        // which FF[4] says to ignore
+        char id[2] = {0, 0};
+        int idLength = 0;
+        size_t start = pos;
+        while (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos]))) {
+            if (std::isupper(static_cast<unsigned char>(text[pos])) && idLength < 3) {
+                if (idLength < 2) {
+                    id[idLength] = text[pos];
+                }
+                idLength++;
+            }
+            pos++;
+        }
+        if (pos == start) {
+            return; // the next node or tree starts here
+        }
+
+        skipWhitespace();
+        if (pos >= text.size() || text[pos] != '[') {
+            fail("Property without a value");
+        }
+
+        while (pos < text.size() && text[pos] == '[') {
+            pos++;
+            std::string_view value = readValue();
+
+            if (idLength == 1 && (id[0] == 'B' || id[0] == 'W')) {
+                Stone color = id[0] == 'B' ? BLACK : WHITE;
+                bool pass = value.empty() || (value == "tt" && game.size <= 19);
+                if (pass) {
+                    game.moves.push_back(SgfMove{color, -1, -1});
+                } else if (value.size() == 2) {
+                    int x = coordinate(value[0]);
+                    int y = coordinate(value[1]);
+                    if (x < 0 || y < 0 || x >= game.size || y >= game.size) {
+                        pos = start;
+                        fail("Move off the board");
+                    }
+                    game.moves.push_back(SgfMove{color, x, y});
+                } else {
+                    pos = start;
+                    fail("Malformed move");
+                }
+            } else if (idLength == 2 && root) {
+                if (id[0] == 'S' && id[1] == 'Z') {
+                    int size = 0;
+                    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), size);
+                    if (error != std::errc() || end != value.data() + value.size() || size < 1 ||
+                        size > MAX_BOARD_SIZE) {
+                        pos = start;
+                        fail("Unsupported board size");
+                    }
+                    game.size = size;
+                } else if (id[0] == 'K' && id[1] == 'M') {
+                    double komi = 0;
+                    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), komi);
+                    game.komi = error == std::errc() ? komi : 0;
+                } else if (id[0] == 'R' && id[1] == 'E') {
+                    game.result = value;
+                } else if (id[0] == 'A' && (id[1] == 'B' || id[1] == 'W')) {
+                    readPoints(value, id[1] == 'B' ? BLACK : WHITE, game, game.setup);
+                }
+            }
+            skipWhitespace();
+        }
+    }
+}
+
+void SgfReader::readPoints(std::string_view value, Stone color, const SgfGame& game, std::vector<SgfMove>& out) {
+    // A single point "ab" or a compressed rectangle "ab:cd"
+    if (value.size() != 2 && !(value.size() == 5 && value[2] == ':')) {
+        fail("Malformed point");
+    }
+    int x1 = coordinate(value[0]);
+    int y1 = coordinate(value[1]);
+    int x2 = value.size() == 5 ? coordinate(value[3]) : x1;
+    int y2 = value.size() == 5 ? coordinate(value[4]) : y1;
+    if (x1 < 0 || y1 < 0 || x2 >= game.size || y2 >= game.size || x1 > x2 || y1 > y2) {
+        fail("Setup point off the board");
+    }
+
+    for (int y = y1; y <= y2; ++y) {
+        for (int x = x1; x <= x2; ++x) {
+            out.push_back(SgfMove{color, x, y});
+        }
+    }
+}
+
+void SgfReader::skipTree() {
+    // pos is at '('; values may contain parentheses, so step over them whole
+    int depth = 0;
+    do {
+        if (pos >= text.size()) {
+            fail("Unterminated variation");
+        }
+
+        char c = text[pos++];
+        if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
+        } else if (c == '[') {
+            readValue();
+        }
+    } while (depth > 0);
+}
+
+void SgfReader::fail(const char* message) const {
+    throw SgfError(message, pos);
+}
+
+namespace {
+
+template <typename Engine>
+ReplayReport replayOn(const SgfGame& game, Engine& inner, const GoEngine& engine,
+                      const std::function<void(const GoEngine&, const SgfMove&)>& onMove) {
+    ReplayReport report;
+
+    // Setup stones go straight onto the board, each side passing in between
+    for (const SgfMove& stone : game.setup) {
+        Stone other = stone.color == BLACK ? WHITE : BLACK;
+        if (inner.getPlayerToMove() != stone.color) {
+            inner.passTurn(other);
+        }
+        inner.placeStone(inner.getPoint(stone.x, stone.y), stone.color);
+    }
+
+    for (size_t i = 0; i < game.moves.size(); ++i) {
+        const SgfMove& move = game.moves[i];
+        if (inner.getPlayerToMove() != move.color) {
+            inner.passTurn(move.color == BLACK ? WHITE : BLACK);
+        }
+        if (onMove) {
+            onMove(engine, move);
+        }
+
+        if (move.x < 0) {
+            inner.passTurn(move.color);
+        } else if (!inner.placeStone(inner.getPoint(move.x, move.y), move.color)) {
+            report.illegalMoves.push_back(static_cast<int>(i));
+            inner.passTurn(move.color);
+        }
+        report.moves++;
+    }
+    return report;
+}
+
+} // namespace
+
+ReplayReport replay(const SgfGame& game, GoEngine& engine,
+                    const std::function<void(const GoEngine&, const SgfMove&)>& onMove) {
+    if (engine.getBoardSize() != game.size) {
+        throw std::invalid_argument("Engine is " + std::to_string(engine.getBoardSize()) + "x" +
+                                    std::to_string(engine.getBoardSize()) + " but the game is " +
+                                    std::to_string(game.size) + "x" + std::to_string(game.size));
+    }
+    return engine.visit([&](auto& inner) { return replayOn(game, inner, engine, onMove); });
+}
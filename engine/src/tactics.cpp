@@ -0,0 +1,288 @@
+#include "tactics.hpp"
+
+#include <algorithm>
+
+template <typename Engine>
+class TacticalSearch {
+public:
+    TacticalSearch(TacticalReader& reader, Engine& engine, int point)
+        : reader(reader), engine(engine), point(point), defender(engine.getStoneAt(point)),
+          attacker(defender == BLACK ? WHITE : BLACK), maxPly(6 * engine.getBoardSize()) {}
+
+    bool attackerWins(int depth, bool ladder);
+    bool defenderEscapes(int depth, bool ladder);
+
+    // Passes for whoever moved last if it is not side's turn; returns
+    // whether it did, for undoTurn
+    bool giveTurn(Stone side) {
+        if (engine.getPlayerToMove() == side) {
+            return false;
+        }
+        engine.doPass(side == BLACK ? WHITE : BLACK);
+        return true;
+    }
+
+    void undoTurn(bool passed) {
+        if (passed) {
+            engine.undoPass();
+        }
+    }
+
+private:
+    static constexpr int MAX_CANDIDATES = 32;
+
+    TacticalReader& reader;
+    Engine& engine;
+    int point;
+    Stone defender;
+    Stone attacker;
+    int maxPly;
+    int ply = 0;
+    int nodes = 0;
+    bool aborted = false;
+
+    bool captured() const { return engine.getStoneAt(point) != defender; }
+
+    bool outOfBudget() {
+        reader.nodes++;
+        if (++nodes > reader.maxNodes || ply >= maxPly) {
+            aborted = true;
+        }
+        return aborted;
+    }
+
+    bool play(int move, Stone stone) {
+        auto [x, y] = engine.getCoordinates(move);
+        if (!engine.doMove(x, y, stone)) {
+            return false;
+        }
+        ply++;
+        return true;
+    }
+
+    void unplay() {
+        engine.undoMove();
+        ply--;
+    }
+
+    int liberties(int chain, int* out) const {
+        auto [x, y] = engine.getCoordinates(chain);
+        int count = 0;
+        engine.getLiberties(x, y).forEach([&](int liberty) { out[count++] = liberty; });
+        return count;
+    }
+
+    uint64_t cacheKey(int depth, bool ladder) const {
+        uint64_t key = engine.getHash() ^ (uint64_t(point) * 0x9E3779B97F4A7C15ULL);
+        key ^= (uint64_t(depth) << 1 | ladder) * 0xC2B2AE3D27D4EB4FULL;
+        return key ^ uint64_t(engine.getBoardSize()) * 0x165667B19E3779F9ULL;
+    }
+};
+
+template <typename Engine>
+bool TacticalSearch<Engine>::attackerWins(int depth, bool ladder) {
+    if (outOfBudget()) {
+        return false;
+    }
+
+    int count = engine.countLiberties(point);
+    if (count == 1) {
+        int liberty;
+        liberties(point, &liberty);
+        bool legal = play(liberty, attacker);
+        if (legal) {
+            unplay();
+        }
+        return legal;
+    }
+    // Each move that does not give atari takes one liberty and one unit of
+    // depth, and a chain with 4 liberties is safe
+    if (count > (ladder ? 2 : std::min(depth + 2, 3))) {
+        return false;
+    }
+
+    uint64_t key = cacheKey(depth, ladder);
+    TacticalReader::CacheEntry& entry = reader.cache[key % TacticalReader::CACHE_ENTRIES];
+    if (entry.key == key) {
+        return entry.captured;
+    }
+
+    int moves[4];
+    liberties(point, moves);
+    bool wins = false;
+    for (int i = 0; i < count && !wins && !aborted; ++i) {
+        if (!play(moves[i], attacker)) {
+            continue;
+        }
+        if (captured()) {
+            wins = true;
+        } else if (engine.countLiberties(point) == 1) {
+            wins = !defenderEscapes(depth, ladder);
+        } else if (!ladder && depth > 0) {
+            wins = !defenderEscapes(depth - 1, ladder);
+        }
+        unplay();
+    }
+
+    if (!aborted) {
+        entry = {key, wins};
+    }
+    return wins;
+}
+
+template <typename Engine>
+bool TacticalSearch<Engine>::defenderEscapes(int depth, bool ladder) {
+    if (outOfBudget()) {
+        return true;
+    }
+
+    int count = engine.countLiberties(point);
+    if (count >= 4) {
+        return true;
+    }
+
+    // Taking an adjacent chain in atari comes first, then extending
+    int moves[MAX_CANDIDATES];
+    int candidates = 0;
+    auto add = [&](int move) {
+        for (int i = 0; i < candidates; ++i) {
+            if (moves[i] == move) {
+                return;
+            }
+        }
+        if (candidates < MAX_CANDIDATES) {
+            moves[candidates++] = move;
+        }
+    };
+
+    int stride = engine.getStride();
+    const int directions[] = {1, -1, stride, -stride};
+    auto [x, y] = engine.getCoordinates(point);
+    engine.getGroup(x, y).forEach([&](int stone) {
+        for (int dir : directions) {
+            int neighbor = stone + dir;
+            if (engine.getStoneAt(neighbor) == attacker && engine.countLiberties(neighbor) == 1) {
+                int liberty;
+                liberties(neighbor, &liberty);
+                add(liberty);
+            }
+        }
+    });
+    int own[4];
+    for (int i = 0, n = liberties(point, own); i < n; ++i) {
+        add(own[i]);
+    }
+
+    for (int i = 0; i < candidates && !aborted; ++i) {
+        if (!play(moves[i], defender)) {
+            continue;
+        }
+        bool escapes = !attackerWins(depth, ladder);
+        unplay();
+        if (escapes) {
+            return true;
+        }
+    }
+
+    // With two liberties the defender may also leave the chain as it is
+    if (count >= 2 && !ladder && !aborted) {
+        engine.doPass(defender);
+        ply++;
+        bool escapes = !attackerWins(depth, ladder);
+        ply--;
+        engine.undoPass();
+        if (escapes) {
+            return true;
+        }
+    }
+    return aborted;
+}
+
+template <int N, int MAX_N>
+bool TacticalReader::isLadderCaptured(BasicGoEngine<N, MAX_N>& engine, int point) {
+    Stone stone = engine.getStoneAt(point);
+    if (stone != BLACK && stone != WHITE) {
+        return false;
+    }
+
+    TacticalSearch search(*this, engine, point);
+    Stone attacker = stone == BLACK ? WHITE : BLACK;
+    switch (engine.countLiberties(point)) {
+    case 1: {
+        bool passed = search.giveTurn(stone);
+        bool captured = !search.defenderEscapes(0, true);
+        search.undoTurn(passed);
+        return captured;
+    }
+    case 2: {
+        bool passed = search.giveTurn(attacker);
+        bool captured = search.attackerWins(0, true);
+        search.undoTurn(passed);
+        return captured;
+    }
+    default:
+        return false;
+    }
+}
+
+template <int N, int MAX_N>
+bool TacticalReader::canEscapeAtari(BasicGoEngine<N, MAX_N>& engine, int point) {
+    Stone stone = engine.getStoneAt(point);
+    if ((stone != BLACK && stone != WHITE) || engine.countLiberties(point) != 1) {
+        return true;
+    }
+
+    TacticalSearch search(*this, engine, point);
+    bool passed = search.giveTurn(stone);
+    bool escapes = search.defenderEscapes(ESCAPE_DEPTH, false);
+    search.undoTurn(passed);
+    return escapes;
+}
+
+template <int N, int MAX_N>
+bool TacticalReader::canCapture(BasicGoEngine<N, MAX_N>& engine, int point, int depth) {
+    Stone stone = engine.getStoneAt(point);
+    if (stone != BLACK && stone != WHITE) {
+        return false;
+    }
+
+    TacticalSearch search(*this, engine, point);
+    bool passed = search.giveTurn(stone == BLACK ? WHITE : BLACK);
+    bool captured = search.attackerWins(depth, false);
+    search.undoTurn(passed);
+    return captured;
+}
+
+template bool TacticalReader::isLadderCaptured(BasicGoEngine<0>& engine, int point);
+template bool TacticalReader::isLadderCaptured(BasicGoEngine<0, MAX_BOARD_SIZE>& engine, int point);
+template bool TacticalReader::isLadderCaptured(BasicGoEngine<9>& engine, int point);
+template bool TacticalReader::isLadderCaptured(BasicGoEngine<13>& engine, int point);
+template bool TacticalReader::isLadderCaptured(BasicGoEngine<19>& engine, int point);
+
+template bool TacticalReader::canEscapeAtari(BasicGoEngine<0>& engine, int point);
+template bool TacticalReader::canEscapeAtari(BasicGoEngine<0, MAX_BOARD_SIZE>& engine, int point);
+template bool TacticalReader::canEscapeAtari(BasicGoEngine<9>& engine, int point);
+template bool TacticalReader::canEscapeAtari(BasicGoEngine<13>& engine, int point);
+template bool TacticalReader::canEscapeAtari(BasicGoEngine<19>& engine, int point);
+
+template bool TacticalReader::canCapture(BasicGoEngine<0>& engine, int point, int depth);
+template bool TacticalReader::canCapture(BasicGoEngine<0, MAX_BOARD_SIZE>& engine, int point, int depth);
+template bool TacticalReader::canCapture(BasicGoEngine<9>& engine, int point, int depth);
+template bool TacticalReader::canCapture(BasicGoEngine<13>& engine, int point, int depth);
+template bool TacticalReader::canCapture(BasicGoEngine<19>& engine, int point, int depth);
+
+bool TacticalReader::isLadderCaptured(GoEngine& engine, int point) {
+    return engine.visit([&](auto& inner) { return isLadderCaptured(inner, point); });
+}
+
+bool TacticalReader::canEscapeAtari(GoEngine& engine, int point) {
+    return engine.visit([&](auto& inner) { return canEscapeAtari(inner, point); });
+}
+
+bool TacticalReader::canCapture(GoEngine& engine, int point, int depth) {
+    return engine.visit([&](auto& inner) { return canCapture(inner, point, depth); });
+}
+
+void TacticalReader::clear() {
+    cache.fill(CacheEntry{});
+}
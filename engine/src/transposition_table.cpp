@@ -0,0 +1,131 @@
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// data layout: visits | half-point wins | age
+constexpr int VISIT_BITS = 28;
+constexpr int WIN_BITS = 29;
+constexpr int AGE_BITS = 7;
+constexpr uint64_t VISIT_MASK = (uint64_t(1) << VISIT_BITS) - 1;
+constexpr uint64_t WIN_MASK = (uint64_t(1) << WIN_BITS) - 1;
+constexpr uint64_t AGE_MASK = (uint64_t(1) << AGE_BITS) - 1;
+
+static_assert(VISIT_BITS + WIN_BITS + AGE_BITS == 64);
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t bytes) {
+    resize(bytes);
+}
+
+void TranspositionTable::resize(size_t bytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+    buckets = std::make_unique<Bucket[]>(count);
+    bucketCount = count;
+    age = 0;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (Entry& entry : buckets[i].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    age = 0;
+}
+
+void TranspositionTable::newSearch() {
+    age = (age + 1) & AGE_MASK;
+}
+
+uint64_t TranspositionTable::pack(const PositionStats& stats) const {
+    uint64_t visits = stats.visits;
+    uint64_t halfWins = static_cast<uint64_t>(std::llround(std::max(0.0, stats.wins) * 2));
+    // Halve both when the visit count would overflow, keeping the ratio
+    while (visits > VISIT_MASK || halfWins > WIN_MASK) {
+        visits /= 2;
+        halfWins /= 2;
+    }
+    return visits << (WIN_BITS + AGE_BITS) | halfWins << AGE_BITS | age;
+}
+
+PositionStats TranspositionTable::unpack(uint64_t data) {
+    PositionStats stats;
+    stats.visits = static_cast<uint32_t>(data >> (WIN_BITS + AGE_BITS));
+    stats.wins = ((data >> AGE_BITS) & WIN_MASK) / 2.0;
+    return stats;
+}
+
+uint8_t TranspositionTable::ageOf(uint64_t data) {
+    return data & AGE_MASK;
+}
+
+bool TranspositionTable::probe(uint64_t key, PositionStats& stats) const {
+    const Bucket& bucket = bucketFor(key);
+    for (const Entry& entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data != 0) {
+            stats = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, const PositionStats& stats) {
+    write(key, pack(stats));
+}
+
+void TranspositionTable::add(uint64_t key, int visits, double wins) {
+    PositionStats stats;
+    probe(key, stats);
+    stats.visits += visits;
+    stats.wins += wins;
+    write(key, pack(stats));
+}
+
+void TranspositionTable::write(uint64_t key, uint64_t data) {
+    Bucket& bucket = bucketFor(key);
+    Entry* victim = &bucket.entries[0];
+    int victimScore = INT32_MAX;
+    for (Entry& entry : bucket.entries) {
+        uint64_t old = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ old) == key || old == 0) {
+            victim = &entry;
+            break;
+        }
+
+        // Older searches first, then fewer visits
+        int staleness = (age - ageOf(old)) & AGE_MASK;
+        int visits = static_cast<int>(std::min<uint64_t>(old >> (WIN_BITS + AGE_BITS), 1 << 20));
+        int score = visits - (staleness << 21);
+        if (score < victimScore) {
+            victimScore = score;
+            victim = &entry;
+        }
+    }
+
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min<size_t>(bucketCount, 250);
+    int current = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        for (const Entry& entry : buckets[i].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            current += data != 0 && ageOf(data) == age;
+        }
+    }
+    return static_cast<int>(current * 1000 / (sample * BUCKET_ENTRIES));
+}
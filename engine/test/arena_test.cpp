@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "arena.hpp"
+
+namespace {
+
+struct Item {
+  int value = 7;
+  int other = 0;
+};
+
+using ItemArena = Arena<Item>;
+
+} // namespace
+
+TEST(ArenaTest, AllocatesDefaultConstructedRuns) {
+  ItemArena arena;
+  ItemArena::Region region(arena);
+  ItemArena::Cursor cursor(region);
+
+  Item* a = cursor.allocate(3);
+  Item* b = cursor.allocate(5);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(b, a + 3);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(b[i].value, 7);
+  }
+  EXPECT_EQ(region.chunkCount(), 1u);
+  EXPECT_EQ(arena.bytesInUse(), ItemArena::CHUNK_BYTES);
+}
+
+TEST(ArenaTest, ReleaseRecyclesChunks) {
+  ItemArena arena;
+  {
+    ItemArena::Region region(arena);
+    ItemArena::Cursor cursor(region);
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_NE(cursor.allocate(ItemArena::CHUNK_ITEMS), nullptr);
+    }
+    EXPECT_EQ(region.chunkCount(), 10u);
+  }
+  EXPECT_EQ(arena.bytesInUse(), 0u);
+  EXPECT_EQ(arena.bytesReserved(), 10 * ItemArena::CHUNK_BYTES);
+
+  // A second tree reuses the same chunks rather than allocating more
+  ItemArena::Region region(arena);
+  ItemArena::Cursor cursor(region);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(cursor.allocate(ItemArena::CHUNK_ITEMS), nullptr);
+  }
+  EXPECT_EQ(arena.bytesReserved(), 10 * ItemArena::CHUNK_BYTES);
+}
+
+TEST(ArenaTest, RespectsBudget) {
+  ItemArena arena(3 * ItemArena::CHUNK_BYTES);
+  ItemArena::Region region(arena);
+  ItemArena::Cursor cursor(region);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(cursor.allocate(ItemArena::CHUNK_ITEMS), nullptr);
+  }
+  EXPECT_EQ(cursor.allocate(1), nullptr);
+
+  region.release();
+  ItemArena::Cursor fresh(region);
+  EXPECT_NE(fresh.allocate(1), nullptr);
+}
+
+TEST(ArenaTest, CursorsOnSeveralThreads) {
+  ItemArena arena;
+  ItemArena::Region region(arena);
+  std::vector<std::vector<Item*>> allocated(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      ItemArena::Cursor cursor(region);
+      for (int i = 0; i < 20000; ++i) {
+        Item* item = cursor.allocate(1 + i % 50);
+        item->other = t;
+        allocated[t].push_back(item);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::set<Item*> distinct;
+  for (int t = 0; t < 4; ++t) {
+    for (Item* item : allocated[t]) {
+      EXPECT_EQ(item->other, t);
+      distinct.insert(item);
+    }
+  }
+  EXPECT_EQ(distinct.size(), 80000u);
+}
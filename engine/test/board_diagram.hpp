@@ -0,0 +1,29 @@
+#ifndef BOARD_DIAGRAM_HPP
+#define BOARD_DIAGRAM_HPP
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "go_engine.hpp"
+
+// Puts down 'X' and 'O' stones row by row, passing for the other side where
+// needed; the diagrams given to it must capture nothing
+template <typename Engine>
+void setUp(Engine& engine, const std::vector<std::string>& rows) {
+  for (int y = 0; y < static_cast<int>(rows.size()); ++y) {
+    for (int x = 0; x < static_cast<int>(rows[y].size()); ++x) {
+      if (rows[y][x] != 'X' && rows[y][x] != 'O') {
+        continue;
+      }
+      Stone stone = rows[y][x] == 'X' ? BLACK : WHITE;
+      if (engine.getPlayerToMove() != stone) {
+        engine.passTurn(stone == BLACK ? WHITE : BLACK);
+      }
+      ASSERT_TRUE(engine.placeStone(x, y, stone)) << x << "," << y;
+    }
+  }
+}
+
+#endif // BOARD_DIAGRAM_HPP
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "features.hpp"
+#include "go_engine.hpp"
+#include "playout.hpp"
+
+namespace {
+
+// Random legal play, remembering every move for the history planes
+GoEngine randomPosition(int size, int moves, uint64_t seed, std::vector<int>& played) {
+  GoEngine engine(size);
+  Rng rng(seed);
+  MoveList legal;
+  for (int i = 0; i < moves; ++i) {
+    engine.generateLegalMoves(legal);
+    Stone player = engine.getPlayerToMove();
+    if (legal.empty() || rng.below(20) == 0) {
+      engine.passTurn(player);
+      played.push_back(PASS);
+      continue;
+    }
+    int point = legal[rng.below(legal.size())];
+    engine.placeStone(point, player);
+    played.push_back(point);
+  }
+  return engine;
+}
+
+// The planes built one point at a time through the public interface
+std::vector<float> referencePlanes(const GoEngine& engine, const std::vector<int>& played, int history) {
+  int size = engine.getBoardSize();
+  int area = size * size;
+  std::vector<float> planes((HISTORY_PLANES + history) * area, 0);
+  Stone player = engine.getPlayerToMove();
+
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      int i = y * size + x;
+      int point = engine.getPoint(x, y);
+      Stone stone = engine.getStoneAt(x, y);
+      if (stone != EMPTY) {
+        planes[(stone == player ? OWN_STONES : OPPONENT_STONES) * area + i] = 1;
+        int liberties = engine.countLiberties(x, y, stone);
+        planes[(LIBERTIES_1 + std::min(liberties, 4) - 1) * area + i] = 1;
+      }
+      if (point == engine.getKoPoint()) {
+        planes[KO_POINT * area + i] = 1;
+      }
+      if (engine.isValidMove(x, y, player)) {
+        planes[LEGAL_MOVES * area + i] = 1;
+      }
+      for (int ago = 0; ago < history && ago < static_cast<int>(played.size()); ++ago) {
+        if (played[played.size() - 1 - ago] == point) {
+          planes[(HISTORY_PLANES + ago) * area + i] = 1;
+        }
+      }
+    }
+  }
+  return planes;
+}
+
+} // namespace
+
+TEST(FeaturesTest, MatchesPointByPointPlanes) {
+  for (int size : {5, 9, 13, 19, 25}) {
+    for (int moves : {0, 1, 30, 200}) {
+      std::vector<int> played;
+      GoEngine engine = randomPosition(size, moves, size * 1000 + moves, played);
+      FeatureSpec spec;
+      std::vector<float> planes(spec.tensorSize(size), -1);
+      extractFeatures(engine, spec, planes.data());
+      EXPECT_EQ(planes, referencePlanes(engine, played, spec.history)) << size << "x" << size << " after " << moves;
+    }
+  }
+}
+
+TEST(FeaturesTest, MarksKoAndHistory) {
+  // Black takes the white stone at (1, 1) by playing (2, 1)
+  GoEngine engine(5);
+  engine.placeStone(1, 0, BLACK);
+  engine.placeStone(2, 0, WHITE);
+  engine.placeStone(0, 1, BLACK);
+  engine.placeStone(3, 1, WHITE);
+  engine.placeStone(1, 2, BLACK);
+  engine.placeStone(2, 2, WHITE);
+  engine.placeStone(4, 4, BLACK);
+  engine.placeStone(1, 1, WHITE);
+  engine.placeStone(2, 1, BLACK);
+  ASSERT_EQ(engine.getKoPoint(), engine.getPoint(1, 1));
+
+  FeatureSpec spec;
+  spec.history = 2;
+  std::vector<uint8_t> planes(spec.tensorSize(5));
+  extractFeatures(engine, spec, planes.data());
+  auto at = [&](int plane, int x, int y) { return planes[plane * 25 + y * 5 + x]; };
+  EXPECT_EQ(at(KO_POINT, 1, 1), 1);
+  EXPECT_EQ(at(LEGAL_MOVES, 1, 1), 0);
+  EXPECT_EQ(at(HISTORY_PLANES, 2, 1), 1);
+  EXPECT_EQ(at(HISTORY_PLANES + 1, 1, 1), 1);
+  EXPECT_EQ(at(OWN_STONES, 2, 0), 1);       // white to move
+  EXPECT_EQ(at(OPPONENT_STONES, 2, 1), 1);
+  EXPECT_EQ(at(LIBERTIES_1, 2, 1), 1);
+
+  // A pass leaves its history plane empty and clears the ko
+  engine.passTurn(WHITE);
+  extractFeatures(engine, spec, planes.data());
+  EXPECT_EQ(at(KO_POINT, 1, 1), 0);
+  for (int i = 0; i < 25; ++i) {
+    EXPECT_EQ(planes[HISTORY_PLANES * 25 + i], 0);
+  }
+  EXPECT_EQ(at(HISTORY_PLANES + 1, 2, 1), 1);
+}
+
+TEST(FeaturesTest, RecentMovesFollowUndo) {
+  GoEngine engine(9);
+  std::vector<int> points;
+  for (int i = 0; i < 12; ++i) {
+    Stone player = i % 2 ? WHITE : BLACK;
+    if (i == 5) {
+      engine.doPass(player);
+      points.push_back(PASS);
+    } else {
+      ASSERT_TRUE(engine.doMove(i % 9, i / 9 * 4, player));
+      points.push_back(engine.getPoint(i % 9, i / 9 * 4));
+    }
+  }
+
+  for (int played = 12; played >= 0; --played) {
+    for (int ago = 0; ago <= MOVE_HISTORY; ++ago) {
+      int expected = ago < played && ago < MOVE_HISTORY ? points[played - 1 - ago] : -1;
+      EXPECT_EQ(engine.getRecentMove(ago), expected) << played << " moves, " << ago << " ago";
+    }
+    if (played > 0) {
+      if (points[played - 1] == PASS) {
+        engine.undoPass();
+      } else {
+        engine.undoMove();
+      }
+    }
+  }
+}
+
+TEST(FeaturesTest, LayoutsAndTypesAgree) {
+  std::vector<int> played;
+  GoEngine engine = randomPosition(9, 60, 7, played);
+  FeatureSpec nchw;
+  FeatureSpec nhwc;
+  nhwc.layout = NHWC;
+  int planes = nchw.planeCount();
+
+  std::vector<float> channelsFirst(nchw.tensorSize(9));
+  std::vector<uint8_t> channelsLast(nhwc.tensorSize(9));
+  extractFeatures(engine, nchw, channelsFirst.data());
+  extractFeatures(engine, nhwc, channelsLast.data());
+  for (int plane = 0; plane < planes; ++plane) {
+    for (int i = 0; i < 81; ++i) {
+      EXPECT_EQ(channelsFirst[plane * 81 + i], channelsLast[i * planes + plane]);
+    }
+  }
+
+  FeatureSpec bad;
+  bad.history = MOVE_HISTORY + 1;
+  EXPECT_THROW(extractFeatures(engine, bad, channelsFirst.data()), std::invalid_argument);
+}
+
+TEST(FeaturesTest, BatchMatchesSinglePositions) {
+  std::vector<GoEngine> engines;
+  std::vector<const GoEngine*> batch;
+  for (int i = 0; i < 13; ++i) {
+    std::vector<int> played;
+    engines.push_back(randomPosition(19, i * 17, i, played));
+  }
+  for (const GoEngine& engine : engines) {
+    batch.push_back(&engine);
+  }
+
+  FeatureSpec spec;
+  spec.layout = NHWC;
+  size_t stride = spec.tensorSize(19);
+  std::vector<float> expected(stride * batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    extractFeatures(*batch[i], spec, expected.data() + i * stride);
+  }
+  for (int threads : {1, 3, 16}) {
+    std::vector<float> actual(expected.size(), -1);
+    extractFeatures(batch, spec, actual.data(), threads);
+    EXPECT_EQ(actual, expected) << threads << " threads";
+  }
+
+  GoEngine other(9);
+  batch.push_back(&other);
+  std::vector<uint8_t> tensor(stride * batch.size());
+  EXPECT_THROW(extractFeatures(batch, spec, tensor.data()), std::invalid_argument);
+}
+
+TEST(FeaturesTest, TransformMatchesTransformedPosition) {
+  std::vector<int> played;
+  GoEngine engine = randomPosition(13, 90, 11, played);
+  for (TensorLayout layout : {NCHW, NHWC}) {
+    FeatureSpec spec;
+    spec.layout = layout;
+    std::vector<float> planes(spec.tensorSize(13));
+    std::vector<float> expected(planes.size());
+    std::vector<float> actual(planes.size());
+    extractFeatures(engine, spec, planes.data());
+
+    for (int s = 0; s < SYMMETRIES; ++s) {
+      Symmetry symmetry = static_cast<Symmetry>(s);
+      extractFeatures(engine.transformed(symmetry), spec, expected.data());
+      transformFeatures(spec, 13, symmetry, planes.data(), actual.data());
+      EXPECT_EQ(actual, expected) << s;
+    }
+  }
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "game_record.hpp"
+#include "go_engine.hpp"
+#include "sgf.hpp"
+
+namespace {
+
+// Replays every game of text both ways and compares the final positions
+void expectSameReplay(const std::string& text, const std::string& path) {
+  {
+    GameRecordWriter writer(path);
+    convertSgf(text, writer);
+  }
+  GameRecordReader records(path);
+  SgfReader reader(text);
+  SgfGame game;
+  size_t i = 0;
+  while (reader.next(game)) {
+    ASSERT_LT(i, records.getGameCount());
+    GameRecord record = records.getGame(i++);
+    EXPECT_EQ(record.size, game.size);
+    EXPECT_DOUBLE_EQ(record.komi, game.komi);
+    EXPECT_EQ(record.result, parseResult(game.result));
+
+    GoEngine fromSgf(game.size);
+    GoEngine fromRecord(record.size);
+    ReplayReport expected = replay(game, fromSgf);
+    ReplayReport actual = replay(record, fromRecord);
+    EXPECT_EQ(actual.moves, expected.moves);
+    EXPECT_EQ(actual.illegalMoves, expected.illegalMoves);
+    EXPECT_EQ(fromRecord.getHash(), fromSgf.getHash());
+    EXPECT_EQ(fromRecord.getPlayerToMove(), fromSgf.getPlayerToMove());
+  }
+  EXPECT_EQ(i, records.getGameCount());
+  std::remove(path.c_str());
+}
+
+} // namespace
+
+TEST(GameRecordTest, ParsesResults) {
+  EXPECT_EQ(parseResult("B+R"), (GameResult{BLACK, GameResult::RESIGN, 0}));
+  EXPECT_EQ(parseResult("W+Resign"), (GameResult{WHITE, GameResult::RESIGN, 0}));
+  EXPECT_EQ(parseResult("W+3.5"), (GameResult{WHITE, GameResult::SCORE, 3.5}));
+  EXPECT_EQ(parseResult("B+T"), (GameResult{BLACK, GameResult::TIME, 0}));
+  EXPECT_EQ(parseResult("B+F"), (GameResult{BLACK, GameResult::FORFEIT, 0}));
+  EXPECT_EQ(parseResult("0"), (GameResult{EMPTY, GameResult::DRAW, 0}));
+  EXPECT_EQ(parseResult("Void"), (GameResult{EMPTY, GameResult::VOID, 0}));
+  EXPECT_EQ(parseResult("?"), GameResult{});
+  EXPECT_EQ(parseResult(""), GameResult{});
+  EXPECT_EQ(parseResult("B+"), (GameResult{BLACK, GameResult::UNKNOWN, 0}));
+
+  for (const char* text : {"B+R", "W+3.5", "B+12", "W+T", "B+F", "0", "Void", "?", "B+"}) {
+    EXPECT_EQ(toString(parseResult(text)), text);
+  }
+}
+
+TEST(GameRecordTest, RoundTripsGames) {
+  std::string path = testing::TempDir() + "game_record_test_round_trip.gor";
+  std::string text =
+      "(;SZ[9]KM[6.5]RE[W+R];B[cc];W[gg](;B[cg];W[])(;B[gc]))"
+      "(;SZ[13]KM[-2]RE[B+12.5]AB[aa:bb][dd]AW[mm];W[ee];B[ff];B[fg])"
+      "(;SZ[52]RE[0];B[ZZ];W[aZ];B[tt])";
+  {
+    GameRecordWriter writer(path);
+    EXPECT_EQ(convertSgf(text, writer), 3u);
+    EXPECT_EQ(writer.getGameCount(), 3u);
+  }
+
+  GameRecordReader reader(path);
+  ASSERT_EQ(reader.getGameCount(), 3u);
+
+  // Read out of order, since access is random
+  GameRecord last = reader.getGame(2);
+  EXPECT_EQ(last.size, 52);
+  EXPECT_EQ(last.result.reason, GameResult::DRAW);
+  ASSERT_EQ(last.getMoveCount(), 3);
+  EXPECT_EQ(last.getMove(0).x, 51);
+  EXPECT_EQ(last.getMove(0).y, 51);
+  EXPECT_EQ(last.getMove(1).color, WHITE);
+  EXPECT_EQ(last.getMove(1).x, 0);
+  EXPECT_EQ(last.getMove(1).y, 51);
+  EXPECT_EQ(last.getMove(2).x, 19);
+
+  GameRecord first = reader.getGame(0);
+  EXPECT_EQ(first.size, 9);
+  EXPECT_DOUBLE_EQ(first.komi, 6.5);
+  EXPECT_EQ(toString(first.result), "W+R");
+  EXPECT_EQ(first.getSetupCount(), 0);
+  ASSERT_EQ(first.getMoveCount(), 4);
+  EXPECT_EQ(first.getMove(2).x, 2);
+  EXPECT_EQ(first.getMove(2).y, 6);
+  EXPECT_EQ(first.getMove(3).color, WHITE);
+  EXPECT_EQ(first.getMove(3).x, -1);
+
+  GameRecord second = reader.getGame(1);
+  EXPECT_DOUBLE_EQ(second.komi, -2);
+  EXPECT_EQ(second.result, (GameResult{BLACK, GameResult::SCORE, 12.5}));
+  ASSERT_EQ(second.getSetupCount(), 6);
+  EXPECT_EQ(second.getSetup(5).color, WHITE);
+  EXPECT_EQ(second.getSetup(5).x, 12);
+  EXPECT_EQ(second.getSetup(5).y, 12);
+
+  EXPECT_THROW(reader.getGame(3), std::out_of_range);
+  std::remove(path.c_str());
+}
+
+TEST(GameRecordTest, ReplayMatchesSgf) {
+  // Captures, an occupied point, suicide, handicap and passes
+  expectSameReplay("(;SZ[5];B[bb];W[bb];B[ab];W[ba];B[ca];W[aa];B[cb];W[dd];B[aa];W[];B[])"
+                   "(;SZ[9]HA[2]AB[cc][gg];W[ee];B[ce];B[ec];W[ed])",
+                   testing::TempDir() + "game_record_test_small.gor");
+
+  // Random games, most moves legal, some not
+  std::string text;
+  uint64_t state = 12345;
+  for (int game = 0; game < 20; ++game) {
+    text += "(;SZ[19]";
+    for (int move = 0; move < 250; ++move) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      text += move % 2 ? ";W[" : ";B[";
+      text += static_cast<char>('a' + (state >> 33) % 19);
+      text += static_cast<char>('a' + (state >> 45) % 19);
+      text += "]";
+    }
+    text += ")";
+  }
+  expectSameReplay(text, testing::TempDir() + "game_record_test_random.gor");
+}
+
+TEST(GameRecordTest, IsCompact) {
+  std::string path = testing::TempDir() + "game_record_test_compact.gor";
+  std::string text = "(;SZ[19]";
+  for (int move = 0; move < 200; ++move) {
+    text += move % 2 ? ";W[" : ";B[";
+    text += static_cast<char>('a' + move % 19);
+    text += static_cast<char>('a' + move / 19);
+    text += "]";
+  }
+  text += ")";
+  {
+    GameRecordWriter writer(path);
+    convertSgf(text, writer);
+  }
+
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  // File header, game header, 2 bytes a move and the index entry
+  EXPECT_LE(static_cast<size_t>(in.tellg()), 24u + 16u + 2u * 200u + 8u + 8u);
+  std::remove(path.c_str());
+}
+
+TEST(GameRecordTest, RejectsDamagedFiles) {
+  std::string path = testing::TempDir() + "game_record_test_damaged.gor";
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "(;SZ[9];B[aa])";
+  }
+  EXPECT_THROW(GameRecordReader{path}, std::runtime_error);
+
+  {
+    GameRecordWriter writer(path);
+    convertSgf("(;SZ[9];B[aa];W[bb])", writer);
+  }
+  std::vector<char> bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  ASSERT_EQ(bytes.size(), 24u + 16u + 4u + 4u + 8u);
+
+  // A move past the last point
+  bytes[40] = static_cast<char>(0xff);
+  bytes[41] = 0x0f;
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+  }
+  GameRecordReader reader(path);
+  EXPECT_THROW(reader.getGame(0), std::runtime_error);
+
+  // An index running past the end
+  bytes[8] = 2;
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+  }
+  EXPECT_THROW(GameRecordReader{path}, std::runtime_error);
+  std::remove(path.c_str());
+}
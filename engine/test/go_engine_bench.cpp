@@ -0,0 +1,300 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "features.hpp"
+#include "go_engine.hpp"
+#include "mcts.hpp"
+#include "playout.hpp"
+
+// Benchmarks for the engine hot paths. Positions are built by seeded random
+// play, so every run measures the same boards. Arguments are {board size,
+// percentage of points filled}; 90 stands in for the endgame.
+
+namespace {
+
+int countStones(const GoEngine& engine) {
+    int stones = 0;
+    for (int x = 0; x < engine.getBoardSize(); ++x) {
+        for (int y = 0; y < engine.getBoardSize(); ++y) {
+            stones += engine.getStoneAt(x, y) != EMPTY;
+        }
+    }
+    return stones;
+}
+
+// Random legal play until the given share of the board holds stones
+GoEngine positionWithFill(int size, int fillPercent, uint64_t seed) {
+    GoEngine engine(size);
+    Rng rng(seed);
+    MoveList moves;
+    const int target = size * size * fillPercent / 100;
+
+    for (int move = 0; move < 20 * size * size && countStones(engine) < target; ++move) {
+        engine.generateLegalMoves(moves);
+        if (moves.empty()) {
+            engine.passTurn(engine.getPlayerToMove());
+            continue;
+        }
+        auto [x, y] = engine.getCoordinates(moves[rng.next() % moves.size()]);
+        engine.placeStone(x, y, engine.getPlayerToMove());
+    }
+    return engine;
+}
+
+void fillLevelArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgsProduct({{9, 13, 19}, {0, 30, 70, 90}});
+}
+
+void BM_PlaceStone(benchmark::State& state) {
+    const GoEngine base = positionWithFill(state.range(0), state.range(1), 1);
+    const GoEngine::Snapshot start = base.snapshot();
+    Rng rng(2);
+    MoveList moves;
+    base.generateLegalMoves(moves);
+
+    // Batches of random moves from the position, drawn before timing starts;
+    // a move may repeat within a batch, and then it is rejected and passed
+    std::vector<std::vector<std::pair<int, int>>> batches(64);
+    for (auto& batch : batches) {
+        for (int i = 0; i < moves.size() && i < 16; ++i) {
+            batch.push_back(base.getCoordinates(moves[rng.next() % moves.size()]));
+        }
+    }
+
+    GoEngine engine = base;
+    size_t next = 0;
+    int64_t placed = 0;
+    for (auto _ : state) {
+        // Each batch starts over from the position
+        engine.restore(start);
+        for (auto [x, y] : batches[next]) {
+            Stone stone = engine.getPlayerToMove();
+            if (engine.placeStone(x, y, stone)) {
+                placed++;
+            } else {
+                engine.passTurn(stone);
+            }
+        }
+        next = (next + 1) % batches.size();
+    }
+    state.SetItemsProcessed(placed);
+}
+BENCHMARK(BM_PlaceStone)->Apply(fillLevelArgs);
+
+void BM_IsValidMove(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+    const int size = engine.getBoardSize();
+    const Stone stone = engine.getPlayerToMove();
+
+    for (auto _ : state) {
+        int valid = 0;
+        for (int x = 0; x < size; ++x) {
+            for (int y = 0; y < size; ++y) {
+                valid += engine.isValidMove(x, y, stone);
+            }
+        }
+        benchmark::DoNotOptimize(valid);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_IsValidMove)->Apply(fillLevelArgs);
+
+void BM_GenerateLegalMoves(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+    MoveList moves;
+
+    for (auto _ : state) {
+        engine.generateLegalMoves(moves);
+        benchmark::DoNotOptimize(moves.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateLegalMoves)->Apply(fillLevelArgs);
+
+void BM_CountLiberties(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+    const int size = engine.getBoardSize();
+    std::vector<std::pair<int, int>> stones;
+    for (int x = 0; x < size; ++x) {
+        for (int y = 0; y < size; ++y) {
+            if (engine.getStoneAt(x, y) != EMPTY) {
+                stones.emplace_back(x, y);
+            }
+        }
+    }
+
+    for (auto _ : state) {
+        int liberties = 0;
+        for (auto [x, y] : stones) {
+            liberties += engine.countLiberties(x, y, engine.getStoneAt(x, y));
+        }
+        benchmark::DoNotOptimize(liberties);
+    }
+    state.SetItemsProcessed(state.iterations() * stones.size());
+}
+BENCHMARK(BM_CountLiberties)->Apply(fillLevelArgs);
+
+// Every capturing move available in the position, played and taken back
+void BM_Captures(benchmark::State& state) {
+    GoEngine engine = positionWithFill(state.range(0), state.range(1), 3);
+    const Stone stone = engine.getPlayerToMove();
+    const Stone opponent = stone == BLACK ? WHITE : BLACK;
+    const int size = engine.getBoardSize();
+    MoveList moves;
+    engine.generateLegalMoves(moves);
+
+    std::vector<std::pair<int, int>> captures;
+    for (int point : moves) {
+        auto [x, y] = engine.getCoordinates(point);
+        const int neighbors[4][2] = {{x + 1, y}, {x - 1, y}, {x, y + 1}, {x, y - 1}};
+        for (const auto& [nx, ny] : neighbors) {
+            if (nx >= 0 && nx < size && ny >= 0 && ny < size &&
+                engine.countLiberties(nx, ny, opponent) == 1) {
+                captures.emplace_back(x, y);
+                break;
+            }
+        }
+    }
+    if (captures.empty()) {
+        state.SkipWithError("position has no capturing moves");
+        return;
+    }
+
+    for (auto _ : state) {
+        for (auto [x, y] : captures) {
+            engine.doMove(x, y, stone);
+            engine.undoMove();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * captures.size());
+}
+BENCHMARK(BM_Captures)->ArgsProduct({{9, 13, 19}, {70, 90}});
+
+void BM_ScoreArea(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 6);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.scoreArea(7.5));
+    }
+}
+BENCHMARK(BM_ScoreArea)->Apply(fillLevelArgs);
+
+// Network input planes for one position, as a data loader builds them
+void BM_ExtractFeatures(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+    FeatureSpec spec;
+    std::vector<float> tensor(spec.tensorSize(engine.getBoardSize()));
+
+    for (auto _ : state) {
+        extractFeatures(engine, spec, tensor.data());
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExtractFeatures)->Apply(fillLevelArgs);
+
+// Smallest hash over the 8 symmetries, from the per-symmetry key tables
+void BM_CanonicalHash(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.canonicalHash());
+    }
+}
+BENCHMARK(BM_CanonicalHash)->Apply(fillLevelArgs);
+
+// Cloning a position: a full copy, undo and superko history included, next
+// to restoring a snapshot of the board and chains alone
+void BM_CopyPosition(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+    GoEngine copy(engine.getBoardSize());
+
+    for (auto _ : state) {
+        copy = engine;
+        benchmark::DoNotOptimize(copy.getHash());
+    }
+}
+BENCHMARK(BM_CopyPosition)->Apply(fillLevelArgs);
+
+void BM_RestoreSnapshot(benchmark::State& state) {
+    const GoEngine engine = positionWithFill(state.range(0), state.range(1), 1);
+
+    engine.visit([&](const auto& inner) {
+        auto copy = inner;
+        for (auto _ : state) {
+            copy.restore(inner.snapshot());
+            benchmark::DoNotOptimize(copy.getHash());
+        }
+    });
+}
+BENCHMARK(BM_RestoreSnapshot)->Apply(fillLevelArgs);
+
+// Light playouts from the empty board, as used by the search
+void BM_RandomPlayout(benchmark::State& state) {
+    const GoEngine empty(state.range(0));
+    Rng rng(4);
+
+    for (auto _ : state) {
+        GoEngine engine = empty;
+        benchmark::DoNotOptimize(playout(engine, rng));
+    }
+    state.counters["playouts_per_second"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RandomPlayout)->Arg(9)->Arg(13)->Arg(19);
+
+// The same playouts on the run-time sized engine, to compare with the above
+void BM_RandomPlayoutDynamicSize(benchmark::State& state) {
+    const BasicGoEngine<0> empty(state.range(0));
+    Rng rng(4);
+
+    for (auto _ : state) {
+        BasicGoEngine<0> engine = empty;
+        benchmark::DoNotOptimize(playout(engine, rng));
+    }
+    state.counters["playouts_per_second"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RandomPlayoutDynamicSize)->Arg(9)->Arg(13)->Arg(19);
+
+// Tree search from the empty board; arguments are {board size, threads}
+void BM_MctsSearch(benchmark::State& state) {
+    const GoEngine empty(state.range(0));
+    SearchOptions options;
+    options.threads = state.range(1);
+    Mcts mcts(options);
+    int64_t playouts = 0;
+
+    for (auto _ : state) {
+        mcts.clear();
+        SearchResult result = mcts.search(empty, SearchBudget{1000, 0});
+        playouts += result.playouts;
+    }
+    state.counters["playouts_per_second"] = benchmark::Counter(playouts, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_MctsSearch)->ArgsProduct({{9, 19}, {1, 2, 4, 8, 16}})->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // JSON unless asked otherwise, so results can be stored and compared
+    std::vector<char*> args(argv, argv + argc);
+    std::string json = "--benchmark_format=json";
+    bool hasFormat = false;
+    for (int i = 1; i < argc; ++i) {
+        hasFormat = hasFormat || std::string(argv[i]).rfind("--benchmark_format", 0) == 0;
+    }
+    if (!hasFormat) {
+        args.push_back(json.data());
+    }
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <queue>
 #include <format>
+#include <random>
+#include <type_traits>
 
 #include <gtest/gtest.h>
 
@@ -13,9 +15,10 @@
 #include <stdexcept>
 #include <cctype>
 
+#include "go_engine.hpp"
+
 constexpr const char STONE_CHARS[] = {'-', 'b', 'w'};
 constexpr const char* STONE_NAMES[] = {"EMPTY", "BLACK", "WHITE"};
-enum Stone { EMPTY, BLACK, WHITE };
 using Board = std::vector<std::vector<Stone>>;
 using Group = std::vector<std::pair<int, int>>;
 using Captures = std::vector<Group>;
@@ -215,6 +218,79 @@ Board applyCapturesAndMove(const Board board, const Move move, const Captures ca
 }
 
 
+// Engine holding every stone of board except the one placed by move, with
+// move.side to play
+GoEngine engineFromBoard(const Board& board, const Move& move) {
+    const int size = board.size();
+    GoEngine engine(size);
+
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            Stone stone = board[i][j];
+            if (stone == EMPTY || (i == move.row && j == move.col)) {
+                continue;
+            }
+            engine.passTurn(stone == BLACK ? WHITE : BLACK);
+            EXPECT_TRUE(engine.placeStone(j, i, stone));
+        }
+    }
+
+    engine.passTurn(move.side == BLACK ? WHITE : BLACK);
+    return engine;
+}
+
+void expectSamePosition(const GoEngine& a, const GoEngine& b) {
+    const int size = a.getBoardSize();
+    ASSERT_EQ(size, b.getBoardSize());
+    EXPECT_EQ(a.getHash(), b.getHash());
+
+    for (int x = 0; x < size; ++x) {
+        for (int y = 0; y < size; ++y) {
+            Stone stone = a.getStoneAt(x, y);
+            ASSERT_EQ(stone, b.getStoneAt(x, y));
+            EXPECT_EQ(a.countLiberties(x, y, stone), b.countLiberties(x, y, stone));
+            EXPECT_TRUE(a.getGroup(x, y) == b.getGroup(x, y));
+            EXPECT_EQ(a.isValidMove(x, y, BLACK), b.isValidMove(x, y, BLACK));
+            EXPECT_EQ(a.isValidMove(x, y, WHITE), b.isValidMove(x, y, WHITE));
+        }
+    }
+}
+
+// Plays move with doMove or doPass, checks the captures against findCaptures,
+// takes it back and checks that the engine is exactly where it started
+void expectUndoRoundTrip(const Board& board, const Move& move) {
+    GoEngine engine = engineFromBoard(board, move);
+    const GoEngine before = engine;
+
+    if (move.row < 0) {
+        engine.doPass(move.side);
+        EXPECT_NE(engine.getHash(), before.getHash());
+        engine.undoPass();
+    } else {
+        ASSERT_TRUE(engine.doMove(move.col, move.row, move.side));
+        Board expected = applyCapturesAndMove(board, move, findCaptures(board, move));
+        for (int i = 0; i < static_cast<int>(board.size()); ++i) {
+            for (int j = 0; j < static_cast<int>(board.size()); ++j) {
+                EXPECT_EQ(engine.getStoneAt(j, i), expected[i][j]);
+            }
+        }
+        engine.undoMove();
+    }
+    expectSamePosition(engine, before);
+
+    // the incremental chain data must carry on exactly like the original's
+    GoEngine replay = before;
+    if (move.row < 0) {
+        engine.passTurn(move.side);
+        replay.passTurn(move.side);
+    } else {
+        engine.placeStone(move.col, move.row, move.side);
+        replay.placeStone(move.col, move.row, move.side);
+    }
+    expectSamePosition(engine, replay);
+}
+
+
 TEST(GoEngineTest, BlankBoardBlackPasses) {
   auto [b, m] = parseGoBoard("- - - - - - - - -" \
                              "- - - - - - - - -" \
@@ -228,6 +304,8 @@ TEST(GoEngineTest, BlankBoardBlackPasses) {
   EXPECT_EQ(printMove(m), "BLACK passed");
   Captures c = findCaptures(b, m);
   EXPECT_EQ(c.size(), 0);
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, BlankBoardWhitePasses) {
@@ -243,6 +321,8 @@ TEST(GoEngineTest, BlankBoardWhitePasses) {
   EXPECT_EQ(printMove(m), "WHITE passed");
   Captures c = findCaptures(b, m);
   EXPECT_EQ(c.size(), 0);
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, BlackPlays) {
@@ -258,6 +338,8 @@ TEST(GoEngineTest, BlackPlays) {
   EXPECT_EQ(printMove(m), "BLACK placed a stone at (0, 0)");
   Captures c = findCaptures(b, m);
   EXPECT_EQ(c.size(), 0);
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, BlackCapturesOneWhiteStone) {
@@ -287,6 +369,8 @@ TEST(GoEngineTest, BlackCapturesOneWhiteStone) {
                                  "- - - - - - - - -" \
                                  "- - - - - - - - -" \
                                  "- - - - - - - - -");
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, KoRule) {
@@ -330,6 +414,8 @@ std::cout << "printBoard:\n" << printBoard(b1, true) << std::endl;
                                   "- - - - - - - - -" \
                                   "- - - - - - - - -" \
                                   "- - - - - - - - -");
+
+  expectUndoRoundTrip(b1, m1);
 }
 
 TEST(GoEngineTest, BlackCapturesFourWhiteStones) {
@@ -358,6 +444,8 @@ TEST(GoEngineTest, BlackCapturesFourWhiteStones) {
                                  "- - - - - - - - -" \
                                  "- - - - - - - - -" \
                                  "- - - - - - - - -");
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, BlackCapturesEightWhiteStones) {
@@ -386,6 +474,8 @@ TEST(GoEngineTest, BlackCapturesEightWhiteStones) {
                                  "- - - - 8 - - - -" \
                                  "- - - - - - - - -" \
                                  "- - - - - - - - -");
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, BlackTKO) {
@@ -402,6 +492,8 @@ TEST(GoEngineTest, BlackTKO) {
   Captures c = findCaptures(b, m);
   EXPECT_EQ(c.size(), 1);
   EXPECT_EQ(c.front().size(), 80);
+
+  expectUndoRoundTrip(b, m);
 }
 
 TEST(GoEngineTest, WhiteTKO) {
@@ -418,6 +510,889 @@ TEST(GoEngineTest, WhiteTKO) {
   Captures c = findCaptures(b, m);
   EXPECT_EQ(c.size(), 1);
   EXPECT_EQ(c.front().size(), 80);
+
+  expectUndoRoundTrip(b, m);
+}
+
+// Liberties of the chain at (x, y), counted from scratch through getStoneAt
+int referenceLiberties(const GoEngine& engine, int x, int y) {
+    const int size = engine.getBoardSize();
+    const Stone color = engine.getStoneAt(x, y);
+    std::vector<std::vector<bool>> visited(size, std::vector<bool>(size, false));
+    std::queue<std::pair<int, int>> q;
+    q.push({x, y});
+    visited[x][y] = true;
+    constexpr int dirs[4][2] = {{-1,0}, {1,0}, {0,-1}, {0,1}};
+
+    int liberties = 0;
+    while (!q.empty()) {
+        auto [cx, cy] = q.front();
+        q.pop();
+
+        for (const auto& [dx, dy] : dirs) {
+            int nx = cx + dx;
+            int ny = cy + dy;
+            if (nx < 0 || nx >= size || ny < 0 || ny >= size || visited[nx][ny]) continue;
+
+            if (engine.getStoneAt(nx, ny) == EMPTY) {
+                visited[nx][ny] = true;
+                liberties++;
+            } else if (engine.getStoneAt(nx, ny) == color) {
+                visited[nx][ny] = true;
+                q.push({nx, ny});
+            }
+        }
+    }
+    return liberties;
+}
+
+TEST(GoEngineTest, ChainLibertiesMatchFloodFill) {
+  GoEngine engine(9);
+  unsigned seed = 12345;
+  Stone turn = BLACK;
+
+  for (int move = 0; move < 400; ++move) {
+    seed = seed * 1103515245 + 12345;
+    int x = (seed >> 16) % 9;
+    int y = (seed >> 8) % 9;
+    if (!engine.placeStone(x, y, turn)) {
+      engine.passTurn(turn);
+    }
+    turn = turn == BLACK ? WHITE : BLACK;
+
+    for (int i = 0; i < 9; ++i) {
+      for (int j = 0; j < 9; ++j) {
+        Stone s = engine.getStoneAt(i, j);
+        if (s != EMPTY) {
+          ASSERT_EQ(engine.countLiberties(i, j, s), referenceLiberties(engine, i, j));
+          ASSERT_EQ(engine.getLiberties(i, j).count(), engine.countLiberties(i, j, s));
+        }
+      }
+    }
+  }
+}
+
+TEST(GoEngineTest, BitboardDilateCrossesWords) {
+  Bitboard b;
+  b.set(63);
+  b.set(448);
+  Bitboard d = b.dilate(21);
+  EXPECT_EQ(d.count(), 10);
+  for (int point : {42, 62, 63, 64, 84, 427, 447, 448, 449, 469}) {
+    EXPECT_TRUE(d.test(point)) << point;
+  }
+}
+
+// Dilation against a bit-by-bit reference, for the word counts engines use
+template <int W>
+void expectDilateMatchesNeighbors(int stride) {
+  BasicBitboard<W> b;
+  unsigned seed = W;
+  for (int i = 0; i < 40; ++i) {
+    seed = seed * 1103515245 + 12345;
+    b.set(stride + 1 + (seed >> 8) % (stride * stride - 2 * stride - 2));
+  }
+
+  BasicBitboard<W> expected;
+  b.forEach([&](int point) {
+    for (int neighbor : {point, point + 1, point - 1, point + stride, point - stride}) {
+      expected.set(neighbor);
+    }
+  });
+  EXPECT_TRUE(b.dilate(stride) == expected) << W;
+}
+
+TEST(GoEngineTest, BitboardDilateAllSizes) {
+  expectDilateMatchesNeighbors<bitboardWords(9)>(11);
+  expectDilateMatchesNeighbors<bitboardWords(13)>(15);
+  expectDilateMatchesNeighbors<bitboardWords(19)>(21);
+  expectDilateMatchesNeighbors<bitboardWords(25)>(27);
+  expectDilateMatchesNeighbors<bitboardWords(MAX_BOARD_SIZE)>(MAX_BOARD_SIZE + 2);
+}
+
+TEST(GoEngineTest, LargeBoardCombCapture) {
+  // One black chain over the whole 52x52 board: rows 0, 2, ..., 50 from x = 0
+  // to 50, joined down column 0; column 51 and the other rows stay empty
+  const int size = MAX_BOARD_SIZE;
+  GoEngine engine(size);
+  for (int y = 0; y <= 50; ++y) {
+    for (int x = 0; x <= 50; ++x) {
+      if (y % 2 == 0 || x == 0) {
+        ASSERT_TRUE(engine.placeStone(x, y, BLACK));
+        engine.passTurn(WHITE);
+      }
+    }
+  }
+  EXPECT_EQ(engine.getGroup(0, 0).count(), 26 * 51 + 25);
+  EXPECT_EQ(engine.countLiberties(0, 0, BLACK), referenceLiberties(engine, 0, 0));
+  EXPECT_EQ(engine.getLiberties(0, 0).count(), engine.countLiberties(0, 0, BLACK));
+
+  // White fills everything else, column 51 first so its stones stay connected
+  std::vector<std::pair<int, int>> fill;
+  for (int y = 0; y < size; ++y) {
+    fill.push_back({51, y});
+  }
+  for (int y = 1; y < size; y += 2) {
+    for (int x = 50; x >= 0; --x) {
+      if (engine.getStoneAt(x, y) == EMPTY) {
+        fill.push_back({x, y});
+      }
+    }
+  }
+  engine.passTurn(BLACK);
+  for (size_t i = 0; i + 1 < fill.size(); ++i) {
+    ASSERT_TRUE(engine.placeStone(fill[i].first, fill[i].second, WHITE)) << i;
+    engine.passTurn(BLACK);
+  }
+  EXPECT_EQ(engine.countLiberties(0, 0, BLACK), 1);
+
+  GoEngine before = engine;
+  ASSERT_TRUE(engine.doMove(fill.back().first, fill.back().second, WHITE));
+  EXPECT_TRUE(engine.getStones(BLACK).empty());
+  EXPECT_EQ(engine.getStones(EMPTY).count(), 26 * 51 + 25);
+  engine.undoMove();
+  expectSamePosition(engine, before);
+}
+
+// Random legal moves from a seeded generator, passing now and then
+GoEngine randomGame(int size, int moves, unsigned seed) {
+  GoEngine engine(size);
+  std::mt19937 rng(seed);
+  MoveList legal;
+  for (int i = 0; i < moves; ++i) {
+    engine.generateLegalMoves(legal);
+    if (legal.empty() || rng() % 16 == 0) {
+      engine.passTurn(engine.getPlayerToMove());
+    } else {
+      engine.placeStone(legal[rng() % legal.size()], engine.getPlayerToMove());
+    }
+  }
+  return engine;
+}
+
+TEST(GoEngineTest, SymmetryTablesArePermutations) {
+  for (int size : {1, 2, 9, 19, 52}) {
+    const SymmetryTable& table = SymmetryTable::forSize(size);
+    EXPECT_EQ(&table, &SymmetryTable::forSize(size));
+    GoEngine engine(size);
+    for (int s = 0; s < SYMMETRIES; ++s) {
+      Symmetry symmetry = static_cast<Symmetry>(s);
+      std::vector<bool> seen(size * size, false);
+      for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+          auto [tx, ty] = transformCoordinates(symmetry, x, y, size);
+          int point = engine.getPoint(x, y);
+          int image = table.transformPoint(symmetry, point);
+          EXPECT_EQ(image, engine.getPoint(tx, ty));
+          EXPECT_EQ(table.transformPoint(inverse(symmetry), image), point);
+          EXPECT_EQ(table.transformIndex(symmetry, y * size + x), ty * size + tx);
+          EXPECT_FALSE(seen[ty * size + tx]);
+          seen[ty * size + tx] = true;
+        }
+      }
+      EXPECT_EQ(table.transformPoint(symmetry, PASS), PASS);
+    }
+  }
+  EXPECT_THROW(SymmetryTable::forSize(53), std::invalid_argument);
+
+  // A rotation by 90 degrees moves the top-left corner to the top-right
+  GoEngine engine(5);
+  MoveList moves;
+  MoveList turned;
+  moves.push_back(engine.getPoint(0, 0));
+  moves.push_back(PASS);
+  moves.push_back(engine.getPoint(1, 3));
+  SymmetryTable::forSize(5).transformMoves(ROTATE_90, moves, turned);
+  ASSERT_EQ(turned.size(), 3);
+  EXPECT_EQ(turned[0], engine.getPoint(4, 0));
+  EXPECT_EQ(turned[1], PASS);
+  EXPECT_EQ(turned[2], engine.getPoint(1, 1));
+}
+
+TEST(GoEngineTest, TransformedPositionsMatchSymmetricHashes) {
+  for (int size : {5, 9, 13, 19, 21}) {
+    GoEngine engine = randomGame(size, size * size, size);
+    EXPECT_EQ(engine.getHash(IDENTITY), engine.getHash());
+    uint64_t canonical = engine.canonicalHash();
+
+    for (int s = 0; s < SYMMETRIES; ++s) {
+      Symmetry symmetry = static_cast<Symmetry>(s);
+      GoEngine turned = engine.transformed(symmetry);
+      EXPECT_EQ(turned.getHash(), engine.getHash(symmetry));
+      EXPECT_EQ(turned.canonicalHash(), canonical);
+      EXPECT_EQ(turned.getPlayerToMove(), engine.getPlayerToMove());
+      EXPECT_LE(canonical, turned.getHash());
+
+      for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+          auto [tx, ty] = transformCoordinates(symmetry, x, y, size);
+          Stone stone = engine.getStoneAt(x, y);
+          ASSERT_EQ(turned.getStoneAt(tx, ty), stone);
+          EXPECT_EQ(turned.countLiberties(tx, ty, stone), engine.countLiberties(x, y, stone));
+        }
+      }
+      const SymmetryTable& table = SymmetryTable::forSize(size);
+      for (int ago = 0; ago < MOVE_HISTORY; ++ago) {
+        int move = engine.getRecentMove(ago);
+        EXPECT_EQ(turned.getRecentMove(ago), move < 0 ? move : table.transformPoint(symmetry, move));
+      }
+
+      // Chains are rebuilt, so play goes on the same way
+      expectSamePosition(turned.transformed(inverse(symmetry)), engine);
+    }
+  }
+}
+
+TEST(GoEngineTest, TransformKeepsKo) {
+  GoEngine engine(5);
+  engine.placeStone(1, 0, BLACK);
+  engine.placeStone(2, 0, WHITE);
+  engine.placeStone(0, 1, BLACK);
+  engine.placeStone(3, 1, WHITE);
+  engine.placeStone(1, 2, BLACK);
+  engine.placeStone(2, 2, WHITE);
+  engine.placeStone(4, 4, BLACK);
+  engine.placeStone(1, 1, WHITE);
+  engine.placeStone(2, 1, BLACK);
+  ASSERT_FALSE(engine.isValidMove(1, 1, WHITE));
+
+  GoEngine turned = engine.transformed(TRANSPOSE);
+  EXPECT_EQ(turned.getKoPoint(), turned.getPoint(1, 1));
+  EXPECT_FALSE(turned.isValidMove(1, 1, WHITE));
+  turned = engine.transformed(FLIP_X);
+  EXPECT_EQ(turned.getKoPoint(), turned.getPoint(3, 1));
+  EXPECT_FALSE(turned.isValidMove(3, 1, WHITE));
+  EXPECT_NE(engine.getHash(FLIP_X), engine.getHash());
+}
+
+TEST(GoEngineTest, BitboardGroupAndLiberties) {
+  GoEngine engine(19);
+  // a chain running along the first row, capped by white
+  for (int x = 0; x < 5; ++x) {
+    engine.placeStone(x, 0, BLACK);
+    engine.passTurn(WHITE);
+  }
+  engine.passTurn(BLACK);
+  engine.placeStone(5, 0, WHITE);
+
+  EXPECT_EQ(engine.getGroup(2, 0).count(), 5);
+  Bitboard liberties = engine.getLiberties(0, 0);
+  EXPECT_EQ(liberties.count(), 5);
+  EXPECT_EQ(engine.countLiberties(0, 0, BLACK), 5);
+  EXPECT_TRUE(engine.getGroup(3, 3).empty());
+}
+
+TEST(GoEngineTest, SuicideIsRejected) {
+  GoEngine engine(3);
+  // - B -
+  // B W -
+  // - - -
+  engine.placeStone(1, 0, BLACK);
+  engine.placeStone(1, 1, WHITE);
+  engine.placeStone(0, 1, BLACK);
+
+  EXPECT_FALSE(engine.isValidMove(0, 0, WHITE)); // no liberty and nothing captured
+  EXPECT_TRUE(engine.isValidMove(2, 0, WHITE));
+
+  engine.passTurn(WHITE);
+  engine.placeStone(2, 1, BLACK);
+  engine.passTurn(WHITE);
+  EXPECT_EQ(engine.countLiberties(1, 1, WHITE), 1);
+
+  engine.placeStone(1, 2, BLACK); // fills the last liberty and captures
+  EXPECT_EQ(engine.getStoneAt(1, 1), EMPTY);
+  EXPECT_EQ(engine.countLiberties(1, 2, BLACK), 3);
+}
+
+// - - - - - -
+// - - W B - -
+// - W * W B -
+// - - W B - -
+// - - - - - -
+// - - - - - -
+// Black to play at (2, 2), taking the white stone at (3, 2) as a ko
+void setUpKo(GoEngine& engine) {
+  engine.placeStone(2, 1, WHITE);
+  engine.placeStone(3, 3, BLACK);
+  engine.placeStone(2, 3, WHITE);
+  engine.placeStone(3, 1, BLACK);
+  engine.placeStone(1, 2, WHITE);
+  engine.placeStone(4, 2, BLACK);
+  engine.placeStone(3, 2, WHITE);
+}
+
+TEST(GoEngineTest, UndoRestoresRandomGames) {
+  for (KoRule rule : {SIMPLE_KO, SITUATIONAL_SUPERKO}) {
+    GoEngine engine(9);
+    engine.setKoRule(rule);
+    std::vector<GoEngine> history;
+    std::vector<bool> passed;
+    unsigned seed = 99;
+    Stone turn = BLACK;
+
+    for (int move = 0; move < 300; ++move) {
+      history.push_back(engine);
+      seed = seed * 1103515245 + 12345;
+      int x = (seed >> 16) % 9;
+      int y = (seed >> 8) % 9;
+      passed.push_back(!engine.doMove(x, y, turn));
+      if (passed.back()) {
+        engine.doPass(turn);
+      }
+      turn = turn == BLACK ? WHITE : BLACK;
+    }
+
+    while (!history.empty()) {
+      if (passed.back()) {
+        engine.undoPass();
+      } else {
+        engine.undoMove();
+      }
+      expectSamePosition(engine, history.back());
+      history.pop_back();
+      passed.pop_back();
+    }
+  }
+}
+
+TEST(GoEngineTest, LegalMovesMatchIsValidMove) {
+  GoEngine engine(9);
+  engine.setKoRule(POSITIONAL_SUPERKO);
+  MoveList moves;
+  unsigned seed = 7;
+  Stone turn = BLACK;
+
+  for (int move = 0; move < 300; ++move) {
+    for (Stone stone : {BLACK, WHITE}) {
+      engine.generateLegalMoves(moves, stone);
+      Bitboard mask = engine.legalMask(stone);
+      int expected = 0;
+      for (int x = 0; x < 9; ++x) {
+        for (int y = 0; y < 9; ++y) {
+          bool valid = engine.isValidMove(x, y, stone);
+          expected += valid;
+          ASSERT_EQ(mask.test(engine.getPoint(x, y)), valid);
+        }
+      }
+      ASSERT_EQ(moves.size(), expected);
+      for (int point : moves) {
+        auto [x, y] = engine.getCoordinates(point);
+        ASSERT_TRUE(engine.isValidMove(x, y, stone));
+      }
+    }
+
+    engine.generateLegalMoves(moves);
+    seed = seed * 1103515245 + 12345;
+    if (moves.empty() || seed % 16 == 0) {
+      engine.passTurn(turn);
+    } else {
+      auto [x, y] = engine.getCoordinates(moves[(seed >> 8) % moves.size()]);
+      ASSERT_TRUE(engine.placeStone(x, y, turn));
+    }
+    turn = turn == BLACK ? WHITE : BLACK;
+  }
+}
+
+TEST(GoEngineTest, SimpleKo) {
+  GoEngine engine(6);
+  setUpKo(engine);
+
+  EXPECT_TRUE(engine.placeStone(2, 2, BLACK));
+  EXPECT_EQ(engine.getStoneAt(3, 2), EMPTY);
+  EXPECT_FALSE(engine.isValidMove(3, 2, WHITE)); // no immediate retake
+
+  engine.placeStone(0, 0, WHITE);
+  engine.placeStone(0, 5, BLACK);
+  EXPECT_TRUE(engine.isValidMove(3, 2, WHITE)); // legal after a ko threat exchange
+  EXPECT_TRUE(engine.placeStone(3, 2, WHITE));
+  EXPECT_EQ(engine.getStoneAt(2, 2), EMPTY);
+  EXPECT_FALSE(engine.isValidMove(2, 2, BLACK));
+}
+
+TEST(GoEngineTest, HashIsIndependentOfMoveOrder) {
+  GoEngine a(9);
+  a.placeStone(2, 2, BLACK);
+  a.placeStone(6, 6, WHITE);
+  a.placeStone(2, 6, BLACK);
+  a.placeStone(6, 2, WHITE);
+
+  GoEngine b(9);
+  b.placeStone(2, 6, BLACK);
+  b.placeStone(6, 2, WHITE);
+  b.placeStone(2, 2, BLACK);
+  EXPECT_NE(a.getHash(), b.getHash());
+  b.placeStone(6, 6, WHITE);
+  EXPECT_EQ(a.getHash(), b.getHash());
+
+  a.passTurn(BLACK);
+  EXPECT_NE(a.getHash(), b.getHash());
+}
+
+TEST(GoEngineTest, HashAfterCaptureMatchesFreshPosition) {
+  GoEngine engine(6);
+  setUpKo(engine);
+  engine.placeStone(2, 2, BLACK);
+  engine.placeStone(0, 0, WHITE);
+  engine.placeStone(0, 5, BLACK);
+
+  // the same stones and player to move, without any capture in the history
+  GoEngine fresh(6);
+  fresh.placeStone(2, 1, WHITE);
+  fresh.placeStone(3, 3, BLACK);
+  fresh.placeStone(2, 3, WHITE);
+  fresh.placeStone(3, 1, BLACK);
+  fresh.placeStone(1, 2, WHITE);
+  fresh.placeStone(4, 2, BLACK);
+  fresh.placeStone(0, 0, WHITE);
+  fresh.placeStone(2, 2, BLACK);
+  fresh.passTurn(WHITE);
+  fresh.placeStone(0, 5, BLACK);
+  EXPECT_EQ(engine.getHash(), fresh.getHash());
+}
+
+TEST(GoEngineTest, SuperkoForbidsRepetitionAfterPasses) {
+  for (KoRule rule : {SIMPLE_KO, POSITIONAL_SUPERKO, SITUATIONAL_SUPERKO}) {
+    GoEngine engine(6);
+    engine.setKoRule(rule);
+    setUpKo(engine);
+    engine.placeStone(2, 2, BLACK);
+    engine.passTurn(WHITE);
+    engine.passTurn(BLACK);
+
+    // retaking now would recreate the position from before black's capture
+    EXPECT_EQ(engine.isValidMove(3, 2, WHITE), rule == SIMPLE_KO) << rule;
+    EXPECT_TRUE(engine.isValidMove(0, 0, WHITE));
+  }
+}
+
+TEST(GoEngineTest, ScoreAreaCountsRegionsReachingOneColor) {
+  const std::string boardStr = R"(
+    - b - w -
+    b b - w w
+    - - b w -
+    w w w w -
+    - - - - -
+  )";
+  auto [board, move] = parseGoBoard(boardStr, 5, BLACK);
+  GoEngine engine = engineFromBoard(board, move);
+  AreaScore area = engine.scoreArea(0.5);
+
+  // black: 4 stones and the corner; the regions at (2,0)-(2,1) and
+  // (0,2)-(1,2) touch white too, so they are neutral
+  EXPECT_EQ(area.black, 5);
+  EXPECT_EQ(area.white, 8 + 1 + 7);
+  EXPECT_DOUBLE_EQ(area.score, 5 - 16 - 0.5);
+  EXPECT_EQ(area.ownerAt(engine.getPoint(0, 0)), BLACK);
+  EXPECT_EQ(area.ownerAt(engine.getPoint(2, 1)), EMPTY);
+  EXPECT_EQ(area.ownerAt(engine.getPoint(0, 2)), EMPTY);
+  EXPECT_EQ(area.ownerAt(engine.getPoint(4, 4)), WHITE);
+  EXPECT_EQ(area.ownerAt(engine.getPoint(3, 0)), WHITE);
+
+  GoEngine blank(9);
+  EXPECT_DOUBLE_EQ(blank.scoreArea(7.5).score, -7.5);
+  EXPECT_TRUE(blank.scoreArea(0).blackArea.empty());
+}
+
+// Breadth-first fill of each empty region, for checking scoreArea
+Stone referenceOwner(const GoEngine& engine, int x0, int y0) {
+  const int size = engine.getBoardSize();
+  Stone stone = engine.getStoneAt(x0, y0);
+  if (stone != EMPTY) {
+    return stone;
+  }
+
+  std::vector<bool> seen(size * size, false);
+  std::queue<std::pair<int, int>> frontier;
+  frontier.push({x0, y0});
+  seen[y0 * size + x0] = true;
+  bool black = false;
+  bool white = false;
+  while (!frontier.empty()) {
+    auto [x, y] = frontier.front();
+    frontier.pop();
+    for (auto [dx, dy] : {std::pair{1, 0}, {-1, 0}, {0, 1}, {0, -1}}) {
+      int nx = x + dx;
+      int ny = y + dy;
+      if (nx < 0 || ny < 0 || nx >= size || ny >= size) {
+        continue;
+      }
+      Stone neighbor = engine.getStoneAt(nx, ny);
+      black = black || neighbor == BLACK;
+      white = white || neighbor == WHITE;
+      if (neighbor == EMPTY && !seen[ny * size + nx]) {
+        seen[ny * size + nx] = true;
+        frontier.push({nx, ny});
+      }
+    }
+  }
+  return black == white ? EMPTY : black ? BLACK : WHITE;
+}
+
+TEST(GoEngineTest, ScoreAreaMatchesRegionFill) {
+  for (int size : {5, 9, 19}) {
+    GoEngine engine(size);
+    unsigned seed = size;
+    Stone turn = BLACK;
+    for (int move = 0; move < size * size * 2; ++move) {
+      seed = seed * 1103515245 + 12345;
+      if (!engine.placeStone((seed >> 16) % size, (seed >> 8) % size, turn)) {
+        engine.passTurn(turn);
+      }
+      turn = turn == BLACK ? WHITE : BLACK;
+
+      if (move % 7 == 0) {
+        AreaScore area = engine.scoreArea(0);
+        int black = 0;
+        int white = 0;
+        for (int x = 0; x < size; ++x) {
+          for (int y = 0; y < size; ++y) {
+            Stone owner = referenceOwner(engine, x, y);
+            ASSERT_EQ(area.ownerAt(engine.getPoint(x, y)), owner) << size << " " << move;
+            black += owner == BLACK;
+            white += owner == WHITE;
+          }
+        }
+        EXPECT_EQ(area.black, black);
+        EXPECT_EQ(area.white, white);
+      }
+    }
+  }
+}
+
+TEST(GoEngineTest, FinalOwnershipRemovesDeadStones) {
+  const std::string boardStr = R"(
+    - w - b - w -
+    w w w w w w w
+    b b b b b b b
+    b - b - b - b
+    b b b b b b b
+    - - - - - - -
+    - - - - - - -
+  )";
+  auto [board, move] = parseGoBoard(boardStr, 7, BLACK);
+  GoEngine engine = engineFromBoard(board, move);
+
+  // black's wall has three eyes, white's chain three regions of its own
+  Bitboard black = engine.passAlive(BLACK);
+  Bitboard white = engine.passAlive(WHITE);
+  EXPECT_EQ(black.count(), 18 + 3);
+  EXPECT_EQ(white.count(), 9 + 5);
+  EXPECT_TRUE(black.test(engine.getPoint(1, 3)));
+  EXPECT_FALSE(black.test(engine.getPoint(0, 5)));
+  EXPECT_TRUE(white.test(engine.getPoint(3, 0)));
+
+  // the black stone at (3,0) cannot live, where area scoring gives it to black
+  Ownership ownership = engine.finalOwnership();
+  EXPECT_EQ(ownership.dead.count(), 1);
+  EXPECT_TRUE(ownership.dead.test(engine.getPoint(3, 0)));
+  EXPECT_EQ(ownership.ownerAt(engine.getPoint(3, 0)), WHITE);
+  EXPECT_EQ(engine.scoreArea(0).ownerAt(engine.getPoint(3, 0)), BLACK);
+  EXPECT_EQ(ownership.whiteArea.count(), 14);
+  EXPECT_EQ(ownership.blackArea.count(), 35);
+  EXPECT_TRUE(ownership.seki.empty());
+  EXPECT_EQ(ownership.passAlive, black | white);
+
+  GoEngine blank(9);
+  EXPECT_TRUE(blank.passAlive(BLACK).empty());
+  EXPECT_TRUE(blank.finalOwnership().blackArea.empty());
+}
+
+TEST(GoEngineTest, FinalOwnershipFindsSimpleSeki) {
+  const std::string boardStr = R"(
+    - b b b - w b - -
+    w w w w w w b - -
+    b b b b b b b - -
+    - - - - - - - - -
+    - - - - - - - - -
+    - - - - - - - - -
+    - - - - - - - - -
+    - - - - - - - - -
+    - - - - - - - - -
+  )";
+  auto [board, move] = parseGoBoard(boardStr, 9, BLACK);
+  GoEngine engine = engineFromBoard(board, move);
+  Ownership ownership = engine.finalOwnership();
+
+  // white's chain, the black stones inside and the two liberties they share
+  EXPECT_EQ(ownership.seki.count(), 7 + 3 + 2);
+  EXPECT_TRUE(ownership.seki.test(engine.getPoint(2, 0)));
+  EXPECT_FALSE(ownership.seki.test(engine.getPoint(6, 0)));
+  EXPECT_EQ(ownership.ownerAt(engine.getPoint(0, 0)), EMPTY);
+  EXPECT_EQ(ownership.ownerAt(engine.getPoint(4, 0)), EMPTY);
+  EXPECT_EQ(ownership.ownerAt(engine.getPoint(0, 1)), WHITE);
+  EXPECT_EQ(ownership.ownerAt(engine.getPoint(8, 8)), BLACK);
+  EXPECT_TRUE(ownership.dead.empty());
+  EXPECT_TRUE(ownership.passAlive.empty());
+}
+
+TEST(GoEngineTest, FinalOwnershipIsConsistent) {
+  for (int size : {5, 9, 19}) {
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+      GoEngine engine = randomGame(size, size * size * 2, seed);
+      Ownership ownership = engine.finalOwnership();
+      EXPECT_TRUE((ownership.blackArea & ownership.whiteArea).empty());
+      Bitboard black = engine.passAlive(BLACK);
+      Bitboard white = engine.passAlive(WHITE);
+      EXPECT_EQ(ownership.blackArea & black, black);
+      EXPECT_EQ(ownership.whiteArea & white, white);
+      EXPECT_EQ(ownership.passAlive & ownership.dead, ownership.dead);
+      ownership.dead.forEach([&](int point) {
+        EXPECT_NE(ownership.ownerAt(point), engine.getStoneAt(point));
+      });
+      ownership.seki.forEach([&](int point) {
+        EXPECT_FALSE(ownership.passAlive.test(point));
+      });
+
+      // with nothing dead and no seki, Tromp-Taylor agrees
+      if (ownership.dead.empty() && ownership.seki.empty()) {
+        AreaScore area = engine.scoreArea(0);
+        EXPECT_EQ(ownership.blackArea, area.blackArea);
+        EXPECT_EQ(ownership.whiteArea, area.whiteArea);
+      }
+    }
+  }
+}
+
+TEST(GoEngineTest, SnapshotRestoresThePosition) {
+  static_assert(std::is_trivially_copyable_v<BasicGoEngine<19>::Snapshot>);
+  BasicGoEngine<9> engine;
+  ASSERT_TRUE(engine.doMove(4, 4, BLACK));
+  BasicGoEngine<9>::Snapshot saved = engine.snapshot();
+  uint64_t hash = engine.getHash();
+  EXPECT_EQ(saved.getHash(), hash);
+  EXPECT_EQ(saved.getStoneAt(4, 4), BLACK);
+  EXPECT_EQ(saved.getPlayerToMove(), WHITE);
+
+  // play on past the snapshot, then go back to it
+  for (int x = 0; x < 6; ++x) {
+    engine.doMove(x, 0, engine.getPlayerToMove());
+  }
+  EXPECT_NE(engine.getHash(), hash);
+  EXPECT_EQ(saved.getStoneAt(0, 0), EMPTY);
+  engine.restore(saved);
+  EXPECT_EQ(engine.getHash(), hash);
+  EXPECT_EQ(engine.getStoneAt(4, 4), BLACK);
+  EXPECT_EQ(engine.getStoneAt(0, 0), EMPTY);
+  EXPECT_EQ(engine.getPlayerToMove(), WHITE);
+  EXPECT_EQ(engine.getRecentMove(0), engine.getPoint(4, 4));
+  EXPECT_EQ(engine.countLiberties(engine.getPoint(4, 4)), 4);
+  EXPECT_TRUE(engine.doMove(0, 0, WHITE));
+  engine.undoMove();
+  EXPECT_EQ(engine.getHash(), hash);
+
+  BasicGoEngine<0> small(7);
+  BasicGoEngine<0> large(13);
+  EXPECT_THROW(large.restore(small.snapshot()), std::invalid_argument);
+}
+
+TEST(GoEngineTest, RestoredGamesPlayOnTheSame) {
+  for (int size : {5, 9, 19, 25}) {
+    GoEngine engine = randomGame(size, size * size, size);
+    GoEngine::Snapshot snapshot = engine.snapshot();
+    GoEngine restored(size);
+    restored.restore(snapshot);
+    expectSamePosition(restored, engine);
+    EXPECT_EQ(restored.getKoPoint(), engine.getKoPoint());
+    EXPECT_EQ(restored.getPlayerToMove(), engine.getPlayerToMove());
+
+    // the writer moves on while the shared copy stays as it was
+    uint64_t hash = engine.getHash();
+    engine.passTurn(engine.getPlayerToMove());
+    GoEngine again(size);
+    again.restore(snapshot);
+    EXPECT_EQ(again.getHash(), hash);
+
+    MoveList moves;
+    restored.generateLegalMoves(moves);
+    for (int i = 0; i < 20 && !moves.empty(); ++i) {
+      int move = moves[i * 7 % moves.size()];
+      Stone stone = restored.getPlayerToMove();
+      ASSERT_EQ(again.placeStone(move, stone), restored.placeStone(move, stone));
+      restored.generateLegalMoves(moves);
+    }
+    expectSamePosition(again, restored);
+
+    GoEngine other(size == 5 ? 7 : 5);
+    EXPECT_THROW(other.restore(snapshot), std::invalid_argument);
+  }
+}
+
+TEST(GoEngineTest, MoveDeltaListsCapturesByChain) {
+  // black at (2,1) takes the white pair above it and the white stone to its left
+  const std::string boardStr = R"(
+    - b w w b
+    b w * b -
+    - b b - -
+    - - - - -
+    - - - - -
+  )";
+  auto [board, move] = parseGoBoard(boardStr, 5, BLACK);
+  GoEngine engine = engineFromBoard(board, move);
+  MoveDelta delta;
+  delta.captured.push_back(99);  // left over from an earlier move
+  ASSERT_TRUE(engine.placeStone(engine.getPoint(2, 1), BLACK, delta));
+
+  EXPECT_EQ(delta.point, engine.getPoint(2, 1));
+  EXPECT_EQ(delta.stone, BLACK);
+  EXPECT_EQ(delta.koPoint, 0);
+  ASSERT_EQ(delta.chainCount, 2);
+  EXPECT_EQ(delta.captured.size(), 3);
+  EXPECT_EQ(delta.chainEnds[1], 3);
+  for (int point : delta.captured) {
+    EXPECT_EQ(engine.getStoneAt(point), EMPTY);
+  }
+  int first = delta.chainEnds[0];
+  EXPECT_TRUE(first == 1 || first == 2);
+
+  // a ko capture reports the point white may not take back
+  GoEngine ko(6);
+  setUpKo(ko);
+  ASSERT_TRUE(ko.placeStone(ko.getPoint(2, 2), BLACK, delta));
+  EXPECT_EQ(delta.koPoint, ko.getPoint(3, 2));
+  ASSERT_EQ(delta.chainCount, 1);
+  EXPECT_EQ(delta.captured[0], ko.getPoint(3, 2));
+
+  // an illegal move leaves delta alone
+  EXPECT_FALSE(ko.placeStone(ko.getPoint(3, 2), WHITE, delta));
+  EXPECT_EQ(delta.point, ko.getPoint(2, 2));
+}
+
+TEST(GoEngineTest, MoveDeltasKeepAMirrorInStep) {
+  for (int size : {5, 9, 19}) {
+    GoEngine engine(size);
+    std::vector<Stone> mirror(engine.getStride() * engine.getStride(), EMPTY);
+    std::mt19937 rng(size);
+    MoveList legal;
+    MoveDelta delta;
+    for (int i = 0; i < size * size * 2; ++i) {
+      engine.generateLegalMoves(legal);
+      if (legal.empty()) {
+        engine.passTurn(engine.getPlayerToMove());
+        continue;
+      }
+      Stone stone = engine.getPlayerToMove();
+      ASSERT_TRUE(engine.placeStone(legal[rng() % legal.size()], stone, delta));
+      mirror[delta.point] = delta.stone;
+      for (int point : delta.captured) {
+        mirror[point] = EMPTY;
+      }
+      EXPECT_EQ(delta.koPoint, engine.getKoPoint());
+      EXPECT_EQ(delta.chainCount == 0, delta.captured.empty());
+      for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+          ASSERT_EQ(mirror[engine.getPoint(x, y)], engine.getStoneAt(x, y)) << size << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(GoEngineTest, ObserverHearsMovesButNotCopies) {
+  GoEngine engine(5);
+  std::vector<MoveDelta> heard;
+  engine.setMoveObserver([&](const MoveDelta& delta) { heard.push_back(delta); });
+
+  engine.placeStone(1, 0, BLACK);
+  engine.placeStone(0, 0, WHITE);
+  EXPECT_FALSE(engine.placeStone(7, 0, BLACK));
+  EXPECT_FALSE(engine.placeStone(1, 0, BLACK));
+  engine.placeStone(engine.getPoint(0, 1), BLACK);  // takes the corner
+  engine.passTurn(WHITE);
+  ASSERT_EQ(heard.size(), 4u);
+  EXPECT_EQ(heard[0].point, engine.getPoint(1, 0));
+  EXPECT_EQ(heard[1].stone, WHITE);
+  ASSERT_EQ(heard[2].captured.size(), 1);
+  EXPECT_EQ(heard[2].captured[0], engine.getPoint(0, 0));
+  EXPECT_EQ(heard[3].point, PASS);
+  EXPECT_EQ(heard[3].stone, WHITE);
+
+  // searches and copies stay silent
+  ASSERT_TRUE(engine.doMove(3, 3, BLACK));
+  engine.undoMove();
+  GoEngine copy = engine;
+  copy.placeStone(3, 3, BLACK);
+  engine = copy;
+  EXPECT_EQ(heard.size(), 4u);
+  engine.placeStone(4, 4, WHITE);
+  EXPECT_EQ(heard.size(), 5u);
+
+  engine.setMoveObserver(nullptr);
+  engine.passTurn(BLACK);
+  EXPECT_EQ(heard.size(), 5u);
+}
+
+// Plays the same seeded game on a fixed-size engine and a run-time sized one
+template <int N>
+void expectSpecializationMatches() {
+  BasicGoEngine<N> fixed;
+  BasicGoEngine<0> dynamic(N);
+  GoEngine wrapped(N);
+  unsigned seed = N;
+  Stone turn = BLACK;
+  MoveList fixedMoves;
+  MoveList dynamicMoves;
+
+  for (int move = 0; move < N * N * 2; ++move) {
+    seed = seed * 1103515245 + 12345;
+    int x = (seed >> 16) % N;
+    int y = (seed >> 8) % N;
+    bool played = fixed.doMove(x, y, turn);
+    ASSERT_EQ(dynamic.doMove(x, y, turn), played);
+    ASSERT_EQ(wrapped.placeStone(x, y, turn), played);
+    if (!played) {
+      fixed.doPass(turn);
+      dynamic.doPass(turn);
+      wrapped.passTurn(turn);
+    }
+    turn = turn == BLACK ? WHITE : BLACK;
+
+    ASSERT_EQ(fixed.getHash(), dynamic.getHash());
+    ASSERT_EQ(fixed.getHash(), wrapped.getHash());
+    ASSERT_TRUE(fixed.getStones(BLACK) == wrapped.getStones(BLACK));
+    fixed.generateLegalMoves(fixedMoves);
+    dynamic.generateLegalMoves(dynamicMoves);
+    ASSERT_EQ(fixedMoves.size(), dynamicMoves.size());
+    for (int i = 0; i < fixedMoves.size(); ++i) {
+      ASSERT_EQ(fixedMoves[i], dynamicMoves[i]);
+    }
+  }
+}
+
+TEST(GoEngineTest, SpecializedSizesMatchDynamicEngine) {
+  expectSpecializationMatches<9>();
+  expectSpecializationMatches<13>();
+  expectSpecializationMatches<19>();
+}
+
+TEST(GoEngineTest, WrapperPicksEngineBySize) {
+  for (int size : {5, 9, 13, 19, 25, MAX_BOARD_SIZE}) {
+    GoEngine engine(size);
+    EXPECT_EQ(engine.getBoardSize(), size);
+    int fixedSize = engine.visit([](const auto& inner) { return std::decay_t<decltype(inner)>::FIXED_SIZE; });
+    EXPECT_EQ(fixedSize, size == 9 || size == 13 || size == 19 ? size : 0);
+  }
+  EXPECT_THROW(BasicGoEngine<0>(MAX_STANDARD_SIZE + 1), std::invalid_argument);
+  EXPECT_NO_THROW((BasicGoEngine<0, MAX_BOARD_SIZE>(MAX_STANDARD_SIZE + 1)));
+  EXPECT_THROW(GoEngine(0), std::invalid_argument);
+  EXPECT_THROW(GoEngine(MAX_BOARD_SIZE + 1), std::invalid_argument);
+  EXPECT_THROW(BasicGoEngine<9>(13), std::invalid_argument);
+}
+
+TEST(GoEngineTest, LargeBoardsAreKeptApart) {
+  // The large engine is boxed, so the standard sizes set the wrapper's size
+  EXPECT_LT(sizeof(GoEngine), sizeof(BasicGoEngine<0, MAX_BOARD_SIZE>));
+
+  GoEngine engine(MAX_BOARD_SIZE);
+  ASSERT_TRUE(engine.placeStone(30, 40, BLACK));
+  GoEngine copy = engine;
+  ASSERT_TRUE(copy.placeStone(31, 40, WHITE));
+  EXPECT_EQ(engine.getStoneAt(31, 40), EMPTY);
+  EXPECT_EQ(copy.getStoneAt(30, 40), BLACK);
+
+  engine = copy;
+  EXPECT_EQ(engine.getStoneAt(31, 40), WHITE);
+  EXPECT_EQ(engine.getHash(), copy.getHash());
+  expectSamePosition(engine.transformed(IDENTITY), copy);
 }
 
 /*
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "board_diagram.hpp"
+#include "go_engine.hpp"
+#include "life_and_death.hpp"
+
+namespace {
+
+LifeAndDeathOptions singleThread() {
+  LifeAndDeathOptions options;
+  options.threads = 1;
+  return options;
+}
+
+// White's corner group; black's wall has liberties outside the region
+const std::vector<std::string> STRAIGHT_THREE = {"...OX....", "OOOOX....", "XXXXX...."};
+const std::vector<std::string> TWO_EYES = {"O.O.OX...", "OOOOOX...", "XXXXXX..."};
+// Neither side can approach: filling a shared liberty is self-atari
+const std::vector<std::string> SEKI_SHAPE = {".XXX.OX..", "OOOOOOX..", "XXXXXXX.."};
+// Black takes at the corner and white can only take back
+const std::vector<std::string> KO_SHAPE = {".OO.OOX..", "OXOOOOX..", "XXXXXXX.."};
+
+} // namespace
+
+TEST(LifeAndDeathTest, StraightThreeDependsOnWhoMovesFirst) {
+  GoEngine engine(9);
+  setUp(engine, STRAIGHT_THREE);
+  LifeAndDeathSolver solver(singleThread());
+  int group = engine.getPoint(0, 1);
+
+  LifeAndDeath attacked = solver.solve(engine, group, BLACK);
+  EXPECT_EQ(attacked.status, DEAD);
+  EXPECT_EQ(attacked.keyMove, engine.getPoint(1, 0));
+  EXPECT_GT(attacked.nodes, 0);
+
+  LifeAndDeath defended = solver.solve(engine, group, WHITE);
+  EXPECT_EQ(defended.status, ALIVE);
+  EXPECT_EQ(defended.keyMove, engine.getPoint(1, 0));
+}
+
+TEST(LifeAndDeathTest, TwoEyesNeedNoReading) {
+  GoEngine engine(9);
+  setUp(engine, TWO_EYES);
+  LifeAndDeathSolver solver(singleThread());
+  for (Stone toMove : {BLACK, WHITE}) {
+    LifeAndDeath result = solver.solve(engine, engine.getPoint(0, 1), toMove);
+    EXPECT_EQ(result.status, ALIVE);
+    EXPECT_EQ(result.keyMove, PASS);
+    EXPECT_EQ(result.nodes, 0);
+  }
+}
+
+TEST(LifeAndDeathTest, SharedLibertiesMakeSeki) {
+  GoEngine engine(9);
+  setUp(engine, SEKI_SHAPE);
+  LifeAndDeathSolver solver(singleThread());
+  for (Stone toMove : {BLACK, WHITE}) {
+    EXPECT_EQ(solver.solve(engine, engine.getPoint(0, 1), toMove).status, SEKI);
+  }
+}
+
+TEST(LifeAndDeathTest, KoForLife) {
+  GoEngine engine(9);
+  setUp(engine, KO_SHAPE);
+  LifeAndDeathSolver solver(singleThread());
+  LifeAndDeath result = solver.solve(engine, engine.getPoint(5, 1), BLACK);
+  EXPECT_EQ(result.status, KO);
+  EXPECT_EQ(result.keyMove, engine.getPoint(0, 0));
+  EXPECT_EQ(solver.solve(engine, engine.getPoint(5, 1), WHITE).status, KO);
+}
+
+TEST(LifeAndDeathTest, ThreadsAgree) {
+  LifeAndDeathOptions options;
+  options.threads = 4;
+  LifeAndDeathSolver parallel(options);
+  LifeAndDeathSolver serial(singleThread());
+  for (const auto& rows : {STRAIGHT_THREE, TWO_EYES, SEKI_SHAPE, KO_SHAPE}) {
+    GoEngine engine(9);
+    setUp(engine, rows);
+    int group = engine.getPoint(5, 1);
+    if (engine.getStoneAt(group) != WHITE) {
+      group = engine.getPoint(0, 1);
+    }
+    for (Stone toMove : {BLACK, WHITE}) {
+      EXPECT_EQ(parallel.solve(engine, group, toMove).status, serial.solve(engine, group, toMove).status);
+    }
+  }
+}
+
+TEST(LifeAndDeathTest, BudgetAndRegion) {
+  GoEngine engine(9);
+  setUp(engine, SEKI_SHAPE);
+  uint64_t hash = engine.getHash();
+
+  LifeAndDeathOptions options = singleThread();
+  options.maxNodes = 10;
+  LifeAndDeathSolver small(options);
+  EXPECT_EQ(small.solve(engine, engine.getPoint(0, 1), BLACK).status, UNRESOLVED);
+
+  // White's stones, the two shared liberties and the black stones between them
+  Bitboard region = enclosedRegion(engine, engine.getPoint(0, 1));
+  EXPECT_EQ(region.count(), 12);
+  EXPECT_TRUE(region.test(engine.getPoint(0, 0)));
+  EXPECT_TRUE(region.test(engine.getPoint(2, 0)));
+  EXPECT_FALSE(region.test(engine.getPoint(6, 0)));
+
+  // Seki from the inside too; the outside wall opens onto the whole board
+  LifeAndDeathSolver solver(singleThread());
+  EXPECT_EQ(solver.solve(engine, engine.getPoint(1, 0), WHITE).status, SEKI);
+  EXPECT_EQ(solver.solve(engine, engine.getPoint(6, 0), WHITE).status, UNRESOLVED);
+  EXPECT_THROW(solver.solve(engine, engine.getPoint(8, 8), WHITE), std::invalid_argument);
+  EXPECT_EQ(engine.getHash(), hash);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "go_engine.hpp"
+#include "mcts.hpp"
+
+namespace {
+
+// Black to move; the white chain in the middle is in atari at (2, 3)
+// - - - - -
+// - B B B -
+// B W W W B
+// - B - B -
+// - - - - -
+GoEngine captureProblem() {
+  GoEngine engine(5);
+  const std::pair<int, int> black[] = {{1, 1}, {2, 1}, {3, 1}, {0, 2}, {4, 2}, {1, 3}, {3, 3}};
+  const std::pair<int, int> white[] = {{1, 2}, {2, 2}, {3, 2}};
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_TRUE(engine.placeStone(black[i].first, black[i].second, BLACK));
+    if (i < 3) {
+      EXPECT_TRUE(engine.placeStone(white[i].first, white[i].second, WHITE));
+    } else {
+      engine.passTurn(WHITE);
+    }
+  }
+  return engine;
+}
+
+} // namespace
+
+TEST(MctsTest, FindsCapture) {
+  GoEngine engine = captureProblem();
+  SearchOptions options;
+  options.threads = 1;
+  options.komi = 0;
+  Mcts mcts(options);
+  SearchResult result = mcts.search(engine, SearchBudget{3000, 0});
+
+  EXPECT_EQ(result.bestMove, engine.getPoint(2, 3));
+  EXPECT_GT(result.winRate, 0.5);
+}
+
+TEST(MctsTest, VisitsMatchBudget) {
+  for (int threads : {1, 4}) {
+    GoEngine engine(7);
+    SearchOptions options;
+    options.threads = threads;
+    Mcts mcts(options);
+    SearchResult result = mcts.search(engine, SearchBudget{2000, 0});
+
+    int64_t total = 0;
+    for (auto [move, visits] : result.visits) {
+      total += visits;
+    }
+    EXPECT_EQ(result.playouts, 2000);
+    EXPECT_EQ(total, 2000);
+    EXPECT_EQ(result.visits.size(), 7 * 7 + 1u); // every point plus pass
+    EXPECT_GT(result.nodes, 50);
+    EXPECT_GT(result.playoutsPerSecond, 0);
+  }
+}
+
+TEST(MctsTest, LeavesPositionUntouched) {
+  GoEngine engine = captureProblem();
+  uint64_t hash = engine.getHash();
+  SearchOptions options;
+  options.threads = 2;
+  Mcts mcts(options);
+  mcts.search(engine, SearchBudget{500, 0});
+
+  EXPECT_EQ(engine.getHash(), hash);
+  EXPECT_EQ(engine.getPlayerToMove(), BLACK);
+}
+
+TEST(MctsTest, ReusesSubtreeAfterMove) {
+  GoEngine engine(7);
+  SearchOptions options;
+  options.threads = 1;
+  Mcts mcts(options);
+  SearchResult first = mcts.search(engine, SearchBudget{2000, 0});
+
+  int kept = 0;
+  for (auto [move, visits] : first.visits) {
+    if (move == first.bestMove) {
+      kept = visits;
+    }
+  }
+  auto [x, y] = engine.getCoordinates(first.bestMove);
+  ASSERT_TRUE(engine.placeStone(x, y, BLACK));
+  mcts.advance(first.bestMove);
+  EXPECT_LT(mcts.getTreeSize(), first.nodes);
+  EXPECT_GT(mcts.getTreeSize(), 1);
+
+  // The kept visits carry over into the next search
+  SearchResult second = mcts.search(engine, SearchBudget{1000, 0});
+  int64_t total = 0;
+  for (auto [move, visits] : second.visits) {
+    total += visits;
+  }
+  EXPECT_EQ(second.playouts, 1000);
+  EXPECT_EQ(total, kept - 1 + 1000);
+
+  // A position the tree knows nothing about starts over
+  GoEngine other(7);
+  SearchResult fresh = mcts.search(other, SearchBudget{500, 0});
+  total = 0;
+  for (auto [move, visits] : fresh.visits) {
+    total += visits;
+  }
+  EXPECT_EQ(total, 500);
+}
+
+TEST(MctsTest, StaysWithinMemoryBudget) {
+  GoEngine engine(9);
+  SearchOptions options;
+  options.threads = 2;
+  options.memoryBytes = 1 << 20;
+  Mcts mcts(options);
+  SearchResult result = mcts.search(engine, SearchBudget{20000, 0});
+
+  EXPECT_EQ(result.playouts, 20000);
+  EXPECT_LE(mcts.getMemoryUsed(), options.memoryBytes);
+  EXPECT_GT(result.nodes, 1000);
+}
+
+TEST(MctsTest, AdvanceAfterTheBudgetIsSpent) {
+  GoEngine engine(19);
+  SearchOptions options;
+  options.threads = 2;
+  options.memoryBytes = size_t(2) << 20;
+  Mcts mcts(options);
+  SearchResult result = mcts.search(engine, SearchBudget{3000, 0});
+  size_t half = options.memoryBytes / 2;
+  EXPECT_LE(mcts.getMemoryUsed(), half);
+  EXPECT_GT(mcts.getMemoryUsed(), half / 2);  // the search ran out of room
+
+  for (int i = 0; i < 2; ++i) {
+    int64_t before = mcts.getTreeSize();
+    Stone player = engine.getPlayerToMove();
+    mcts.advance(result.bestMove);
+    EXPECT_GE(mcts.getTreeSize(), 1);  // kept, not started over
+    EXPECT_LT(mcts.getTreeSize(), before);
+    EXPECT_LE(mcts.getMemoryUsed(), half);
+    if (result.bestMove == PASS) {
+      engine.passTurn(player);
+    } else {
+      ASSERT_TRUE(engine.placeStone(result.bestMove, player));
+    }
+
+    result = mcts.search(engine, SearchBudget{1000, 0});
+    EXPECT_EQ(result.playouts, 1000);
+    EXPECT_LE(mcts.getMemoryUsed(), half);
+  }
+}
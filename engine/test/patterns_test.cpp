@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+
+#include "go_engine.hpp"
+#include "patterns.hpp"
+
+namespace {
+
+const int DX[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+const int DY[8] = {-1, 0, 1, 0, -1, 1, 1, -1};
+
+// The neighborhood of (x, y) spelled out: '#' off the board, '.' empty,
+// 'X'/'O' for black and white, 'x'/'o' for orthogonal neighbors in atari
+std::string neighborhood(const GoEngine& engine, int x, int y) {
+  int size = engine.getBoardSize();
+  std::string text;
+  for (int d = 0; d < 8; ++d) {
+    int nx = x + DX[d];
+    int ny = y + DY[d];
+    if (nx < 0 || ny < 0 || nx >= size || ny >= size) {
+      text += '#';
+      continue;
+    }
+    Stone stone = engine.getStoneAt(nx, ny);
+    bool atari = d < 4 && stone != EMPTY && engine.countLiberties(nx, ny, stone) == 1;
+    text += stone == EMPTY ? '.' : stone == BLACK ? (atari ? 'x' : 'X') : (atari ? 'o' : 'O');
+  }
+  return text;
+}
+
+// The documented numbering, worked out from the spelled-out neighborhood
+int referenceCode(const std::string& text) {
+  int begin = 0;
+  int sides = 0;
+  for (int d = 0; d < 4; ++d) {
+    sides |= (text[d] == '#') << d;
+  }
+  for (int other = 0; other < sides; ++other) {
+    int count = 1;
+    for (int d = 0; d < 4; ++d) {
+      bool off = other & (1 << d);
+      bool diagonalOff = off || other & (1 << (d + 1) % 4);
+      count *= (off ? 1 : 5) * (diagonalOff ? 1 : 3);
+    }
+    begin += count;
+  }
+
+  int code = 0;
+  int place = 1;
+  for (int d = 0; d < 8; ++d) {
+    if (text[d] == '#') {
+      continue;
+    }
+    int digit = std::string(".XOxo").find(text[d]);
+    code += digit * place;
+    place *= d < 4 ? 5 : 3;
+  }
+  return begin + code;
+}
+
+void expectPatterns(const GoEngine& engine, std::map<int, std::string>& seen) {
+  int size = engine.getBoardSize();
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      std::string text = neighborhood(engine, x, y);
+      int code = engine.getPattern(engine.getPoint(x, y));
+      ASSERT_EQ(code, referenceCode(text)) << size << "x" << size << " (" << x << ", " << y << ") " << text;
+      ASSERT_LT(code, PatternTable::CODES);
+
+      // One code, one neighborhood
+      auto [it, inserted] = seen.emplace(code, text);
+      ASSERT_EQ(it->second, text);
+    }
+  }
+}
+
+} // namespace
+
+TEST(PatternsTest, FollowsPlacementsAndCaptures) {
+  std::map<int, std::string> seen;
+  for (int size : {1, 2, 3, 5, 9, 19, 25}) {
+    GoEngine engine(size);
+    std::mt19937 rng(size);
+    MoveList legal;
+    expectPatterns(engine, seen);
+    for (int move = 0; move < 3 * size * size; ++move) {
+      engine.generateLegalMoves(legal);
+      if (legal.empty()) {
+        engine.passTurn(engine.getPlayerToMove());
+        continue;
+      }
+      engine.placeStone(legal[rng() % legal.size()], engine.getPlayerToMove());
+      if (move % 7 == 0 || size < 9) {
+        expectPatterns(engine, seen);
+      }
+    }
+    expectPatterns(engine, seen);
+  }
+}
+
+TEST(PatternsTest, FollowsUndo) {
+  GoEngine engine(9);
+  std::mt19937 rng(3);
+  MoveList legal;
+  std::map<int, std::string> seen;
+  int played = 0;
+  for (int move = 0; move < 300; ++move) {
+    engine.generateLegalMoves(legal);
+    if (legal.empty()) {
+      break;
+    }
+    auto [x, y] = engine.getCoordinates(legal[rng() % legal.size()]);
+    ASSERT_TRUE(engine.doMove(x, y, engine.getPlayerToMove()));
+    played++;
+  }
+  for (; played > 0; --played) {
+    engine.undoMove();
+    if (played % 5 == 0) {
+      expectPatterns(engine, seen);
+    }
+  }
+  expectPatterns(engine, seen);
+}
+
+TEST(PatternsTest, LoadsWeights) {
+  std::string path = testing::TempDir() + "patterns_test_weights.txt";
+  {
+    std::ofstream out(path);
+    out << "# code weight\n\n0 2.5\n  50624\t0.25\r\n55495 7\n";
+  }
+  PatternWeights weights(1.0f);
+  weights.load(path);
+  EXPECT_FLOAT_EQ(weights[0], 2.5f);
+  EXPECT_FLOAT_EQ(weights[50624], 0.25f);
+  EXPECT_FLOAT_EQ(weights[55495], 7.0f);
+  EXPECT_FLOAT_EQ(weights[1], 1.0f);
+
+  for (const char* bad : {"55496 1\n", "12\n", "12 x\n", "-1 1\n", "3 1 2\n"}) {
+    {
+      std::ofstream out(path);
+      out << "# fine\n" << bad;
+    }
+    try {
+      weights.load(path);
+      ADD_FAILURE() << bad;
+    } catch (const std::runtime_error& error) {
+      EXPECT_NE(std::string(error.what()).find(":2:"), std::string::npos) << error.what();
+    }
+  }
+  std::remove(path.c_str());
+  EXPECT_THROW(weights.load("/nonexistent/weights.txt"), std::runtime_error);
+}
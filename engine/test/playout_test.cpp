@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "go_engine.hpp"
+#include "playout.hpp"
+
+TEST(PlayoutTest, TrueEyes) {
+  GoEngine engine(5);
+  // - B - - -
+  // B - B - -
+  // - B - - -
+  // - - - - -
+  // - - - - -
+  for (auto [x, y] : {std::pair{1, 0}, {0, 1}, {2, 1}, {1, 2}}) {
+    engine.placeStone(x, y, BLACK);
+    engine.passTurn(WHITE);
+  }
+  EXPECT_TRUE(engine.isTrueEye(engine.getPoint(0, 0), BLACK));
+  EXPECT_TRUE(engine.isTrueEye(engine.getPoint(1, 1), BLACK));
+  EXPECT_FALSE(engine.isTrueEye(engine.getPoint(1, 1), WHITE));
+  EXPECT_FALSE(engine.isTrueEye(engine.getPoint(3, 3), BLACK));
+
+  // a single white diagonal spoils the edge eye but not the center one
+  engine.passTurn(BLACK);
+  ASSERT_TRUE(engine.placeStone(2, 0, WHITE));
+  EXPECT_TRUE(engine.isTrueEye(engine.getPoint(1, 1), BLACK));
+  ASSERT_TRUE(engine.placeStone(3, 3, BLACK));
+  ASSERT_TRUE(engine.placeStone(0, 2, WHITE));
+  EXPECT_FALSE(engine.isTrueEye(engine.getPoint(1, 1), BLACK));
+  EXPECT_TRUE(engine.isTrueEye(engine.getPoint(0, 0), BLACK));
+}
+
+TEST(PlayoutTest, PlaysToTheEnd) {
+  for (int size : {5, 9, 19}) {
+    Rng rng(size);
+    GoEngine engine(size);
+    int score = playout(engine, rng);
+
+    EXPECT_LE(score, size * size);
+    EXPECT_GE(score, -size * size);
+
+    // nothing left but eyes: every empty point is a true eye of one side,
+    // or a point neither side may play
+    MoveList moves;
+    for (Stone stone : {BLACK, WHITE}) {
+      GoEngine copy = engine;
+      copy.passTurn(stone == BLACK ? WHITE : BLACK);
+      copy.generateLegalMoves(moves, stone);
+      for (int point : moves) {
+        EXPECT_TRUE(copy.isTrueEye(point, stone));
+      }
+    }
+  }
+}
+
+TEST(PlayoutTest, SameSeedSameGame) {
+  GoEngine first(9);
+  GoEngine second(9);
+  Rng a(42);
+  Rng b(42);
+  EXPECT_EQ(playout(first, a), playout(second, b));
+  EXPECT_EQ(first.getHash(), second.getHash());
+}
+
+// Black's wall with three eyes above an empty bottom, white's corner chain
+// with three regions of its own, and a hopeless black stone between them
+GoEngine settledCorner() {
+  GoEngine engine(7);
+  const char* rows[] = {".O.X.O.", "OOOOOOO", "XXXXXXX", "X.X.X.X", "XXXXXXX"};
+  for (int y = 0; y < 5; ++y) {
+    for (int x = 0; x < 7; ++x) {
+      if (rows[y][x] == '.') {
+        continue;
+      }
+      Stone stone = rows[y][x] == 'X' ? BLACK : WHITE;
+      engine.passTurn(stone == BLACK ? WHITE : BLACK);
+      EXPECT_TRUE(engine.placeStone(x, y, stone));
+    }
+  }
+  return engine;
+}
+
+TEST(PlayoutTest, OwnershipOfSettledChains) {
+  GoEngine engine = settledCorner();
+  OwnershipEstimate estimate = estimateOwnership(engine, 200, 2);
+  EXPECT_EQ(estimate.size, 7);
+  EXPECT_EQ(estimate.playouts, 200);
+  ASSERT_EQ(estimate.ownership.size(), 49u);
+
+  // pass-alive stones are never taken, and the bottom is black's to fill
+  EXPECT_FLOAT_EQ(estimate.at(0, 1), -1.0f);
+  EXPECT_FLOAT_EQ(estimate.at(0, 2), 1.0f);
+  EXPECT_FLOAT_EQ(estimate.at(3, 6), 1.0f);
+  EXPECT_FLOAT_EQ(estimate.at(3, 0), -1.0f);
+  EXPECT_EQ(estimate.dead.count(), 1);
+  EXPECT_TRUE(estimate.dead.test(engine.getPoint(3, 0)));
+
+  OwnershipEstimate none = estimateOwnership(engine, 0);
+  EXPECT_EQ(none.playouts, 0);
+  EXPECT_FLOAT_EQ(none.at(3, 0), 0.0f);
+  EXPECT_EQ(none.dead, estimate.dead);
+}
+
+TEST(PlayoutTest, OwnershipFindsStonesBensonCannot) {
+  // Black's two walls share one region, so neither is pass-alive yet, and
+  // the white stone has no room to live behind them
+  GoEngine engine(7);
+  for (int x = 0; x < 7; ++x) {
+    for (int y : {2, 4}) {
+      engine.placeStone(x, y, BLACK);
+      engine.passTurn(WHITE);
+    }
+  }
+  engine.passTurn(BLACK);
+  engine.placeStone(3, 0, WHITE);
+  ASSERT_TRUE(engine.passAlive(BLACK).empty());
+  ASSERT_TRUE(engine.finalOwnership().dead.empty());
+
+  OwnershipEstimate estimate = estimateOwnership(engine, 400, 4);
+  EXPECT_EQ(estimate.dead.count(), 1);
+  EXPECT_TRUE(estimate.dead.test(engine.getPoint(3, 0)));
+  for (float value : estimate.ownership) {
+    EXPECT_GE(value, -1.0f);
+    EXPECT_LE(value, 1.0f);
+  }
+  EXPECT_GT(estimate.at(3, 6), 0.5f);
+}
+
+TEST(PlayoutTest, OwnershipIsIndependentOfThreads) {
+  GoEngine engine(9);
+  Rng rng(7);
+  for (int i = 0; i < 30; ++i) {
+    MoveList moves;
+    engine.generateLegalMoves(moves);
+    engine.placeStone(moves[rng.below(moves.size())], engine.getPlayerToMove());
+  }
+  uint64_t hash = engine.getHash();
+
+  OwnershipEstimate serial = estimateOwnership(engine, 100, 1);
+  for (int threads : {2, 3, 8, 0}) {
+    OwnershipEstimate parallel = estimateOwnership(engine, 100, threads);
+    EXPECT_EQ(parallel.ownership, serial.ownership) << threads;
+    EXPECT_EQ(parallel.dead, serial.dead) << threads;
+  }
+  EXPECT_EQ(engine.getHash(), hash);
+}
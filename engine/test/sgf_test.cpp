@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "go_engine.hpp"
+#include "sgf.hpp"
+
+TEST(SgfTest, ReadsCollectionAndFollowsMainLine) {
+  std::string text =
+      "junk before (;FF[4]GM[1]SZ[9]KM[6.5]RE[W+R]C[a comment \\] with ( and )]"
+      ";B[cc];W[gg](;B[cg];W[]C[first])(;B[gc](;W[cd])))\n"
+      "(;SZ[13]AB[aa:bb][dd]AW[mm];W[ee]PL[B];B[ff])";
+  SgfReader reader(text);
+  SgfGame game;
+
+  ASSERT_TRUE(reader.next(game));
+  EXPECT_EQ(game.size, 9);
+  EXPECT_DOUBLE_EQ(game.komi, 6.5);
+  EXPECT_EQ(game.result, "W+R");
+  EXPECT_TRUE(game.setup.empty());
+  ASSERT_EQ(game.moves.size(), 4u);
+  EXPECT_EQ(game.moves[0].color, BLACK);
+  EXPECT_EQ(game.moves[0].x, 2);
+  EXPECT_EQ(game.moves[0].y, 2);
+  EXPECT_EQ(game.moves[1].color, WHITE);
+  EXPECT_EQ(game.moves[2].x, 2);
+  EXPECT_EQ(game.moves[2].y, 6);
+  EXPECT_EQ(game.moves[3].color, WHITE);
+  EXPECT_EQ(game.moves[3].x, -1);
+
+  ASSERT_TRUE(reader.next(game));
+  EXPECT_EQ(game.size, 13);
+  EXPECT_DOUBLE_EQ(game.komi, 0);
+  EXPECT_TRUE(game.result.empty());
+  ASSERT_EQ(game.setup.size(), 6u);
+  EXPECT_EQ(game.setup[4].color, BLACK);
+  EXPECT_EQ(game.setup[4].x, 3);
+  EXPECT_EQ(game.setup[5].color, WHITE);
+  EXPECT_EQ(game.setup[5].x, 12);
+  EXPECT_EQ(game.moves.size(), 2u);
+
+  EXPECT_FALSE(reader.next(game));
+  EXPECT_EQ(reader.getOffset(), text.size());
+}
+
+TEST(SgfTest, ReadsPassesAndLargeBoards) {
+  SgfReader small("(;SZ[19];B[tt];W[])");
+  SgfGame game;
+  ASSERT_TRUE(small.next(game));
+  ASSERT_EQ(game.moves.size(), 2u);
+  EXPECT_EQ(game.moves[0].x, -1);
+  EXPECT_EQ(game.moves[1].x, -1);
+
+  // Past 19 lines "tt" is a real point and upper case carries on from z
+  SgfReader large("(;SZ[52];B[tt];W[ZA])");
+  ASSERT_TRUE(large.next(game));
+  EXPECT_EQ(game.size, 52);
+  ASSERT_EQ(game.moves.size(), 2u);
+  EXPECT_EQ(game.moves[0].x, 19);
+  EXPECT_EQ(game.moves[1].x, 51);
+  EXPECT_EQ(game.moves[1].y, 26);
+}
+
+TEST(SgfTest, RejectsMalformedText) {
+  const char* bad[] = {
+      "(;SZ[9];B[cc]",          // unterminated tree
+      "(;SZ[9];B[cc",           // unterminated value
+      "(;SZ[9];B[jj])",         // off the board
+      "(;SZ[9];B[abc])",        // malformed move
+      "(;SZ[53])",              // too large
+      "(;SZ[9]B)",              // property without a value
+      "(;SZ[9])(;B[aa]x)",      // stray character
+      "(;SZ[9](;B[aa]);W[bb])", // node after a variation
+      "()",                     // no nodes
+  };
+  for (const char* text : bad) {
+    SgfReader reader(text);
+    SgfGame game;
+    EXPECT_THROW(while (reader.next(game)) {}, SgfError) << text;
+  }
+}
+
+TEST(SgfTest, ReplayReportsIllegalMoves) {
+  // White plays on black's stone, then black captures at a1
+  SgfReader reader("(;SZ[5];B[bb];W[bb];B[ab];W[ba];B[ca];W[aa];B[cb];W[dd];B[aa])");
+  SgfGame game;
+  ASSERT_TRUE(reader.next(game));
+
+  GoEngine engine(5);
+  int seen = 0;
+  ReplayReport report = replay(game, engine, [&](const GoEngine& position, const SgfMove& move) {
+    EXPECT_EQ(position.getPlayerToMove(), move.color);
+    seen++;
+  });
+  EXPECT_EQ(report.moves, 9);
+  EXPECT_EQ(seen, 9);
+  ASSERT_EQ(report.illegalMoves.size(), 2u);
+  EXPECT_EQ(report.illegalMoves[0], 1); // occupied
+  EXPECT_EQ(report.illegalMoves[1], 5); // suicide
+  EXPECT_EQ(engine.getStoneAt(0, 0), BLACK);
+
+  GoEngine wrongSize(9);
+  EXPECT_THROW(replay(game, wrongSize), std::invalid_argument);
+}
+
+TEST(SgfTest, ReplayPassesForHandicap) {
+  SgfReader reader("(;SZ[9]HA[2]AB[cc][gg];W[ee];B[ce];B[ec])");
+  SgfGame game;
+  ASSERT_TRUE(reader.next(game));
+
+  GoEngine engine(9);
+  ReplayReport report = replay(game, engine);
+  EXPECT_TRUE(report.illegalMoves.empty());
+  EXPECT_EQ(engine.getStoneAt(2, 2), BLACK);
+  EXPECT_EQ(engine.getStoneAt(6, 6), BLACK);
+  EXPECT_EQ(engine.getStoneAt(4, 4), WHITE);
+  EXPECT_EQ(engine.getStoneAt(4, 2), BLACK);
+  EXPECT_EQ(engine.getPlayerToMove(), WHITE);
+}
+
+TEST(SgfTest, MapsFiles) {
+  std::string path = testing::TempDir() + "sgf_test_collection.sgf";
+  {
+    std::ofstream out(path);
+    out << "(;SZ[9];B[aa])(;SZ[9];B[bb])";
+  }
+
+  MappedFile file(path);
+  SgfReader reader(file.contents());
+  SgfGame game;
+  int games = 0;
+  while (reader.next(game)) {
+    games++;
+  }
+  EXPECT_EQ(games, 2);
+  std::remove(path.c_str());
+
+  EXPECT_THROW(MappedFile("/nonexistent/file.sgf"), std::runtime_error);
+}
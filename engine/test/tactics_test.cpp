@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "board_diagram.hpp"
+#include "go_engine.hpp"
+#include "tactics.hpp"
+
+namespace {
+
+const std::vector<std::string> LADDER = {
+    ".........",
+    "..X......",
+    ".XO......",
+    ".X.......",
+    ".........",
+    ".........",
+    ".........",
+    ".........",
+    ".........",
+};
+
+} // namespace
+
+TEST(TacticsTest, LadderOnAnEmptyBoardWorks) {
+  GoEngine engine(9);
+  setUp(engine, LADDER);
+  TacticalReader reader;
+  EXPECT_TRUE(reader.isLadderCaptured(engine, engine.getPoint(2, 2)));
+  EXPECT_TRUE(reader.canCapture(engine, engine.getPoint(2, 2), 0));
+
+  // Once in atari the chain still cannot run
+  engine.passTurn(WHITE);
+  ASSERT_TRUE(engine.doMove(3, 2, BLACK));
+  EXPECT_TRUE(reader.isLadderCaptured(engine, engine.getPoint(2, 2)));
+  EXPECT_FALSE(reader.canEscapeAtari(engine, engine.getPoint(2, 2)));
+}
+
+TEST(TacticsTest, LadderBreakerSavesTheChain) {
+  std::vector<std::string> rows = LADDER;
+  rows[6][6] = 'O';
+  GoEngine engine(9);
+  setUp(engine, rows);
+  TacticalReader reader;
+  EXPECT_FALSE(reader.isLadderCaptured(engine, engine.getPoint(2, 2)));
+  EXPECT_FALSE(reader.canCapture(engine, engine.getPoint(2, 2), 0));
+
+  engine.passTurn(WHITE);
+  ASSERT_TRUE(engine.doMove(3, 2, BLACK));
+  EXPECT_FALSE(reader.isLadderCaptured(engine, engine.getPoint(2, 2)));
+}
+
+TEST(TacticsTest, EscapesAtariByCapturing) {
+  GoEngine engine(9);
+  setUp(engine, {
+      "OX.......",
+      ".X.......",
+      "X........",
+  });
+  TacticalReader reader;
+  int corner = engine.getPoint(0, 0);
+  EXPECT_FALSE(reader.canEscapeAtari(engine, corner));
+
+  // With the black pair down to one liberty, taking it saves the corner
+  GoEngine saved(9);
+  setUp(saved, {
+      "OXO......",
+      ".XO......",
+      "XO.......",
+  });
+  EXPECT_TRUE(reader.canEscapeAtari(saved, corner));
+  EXPECT_TRUE(reader.canEscapeAtari(saved, saved.getPoint(4, 4)));  // empty point
+}
+
+TEST(TacticsTest, CaptureDepthCountsMovesThatDoNotGiveAtari) {
+  GoEngine engine(9);
+  setUp(engine, {
+      "OO.X.....",
+      "..X......",
+      "XX.......",
+  });
+  TacticalReader reader;
+  int point = engine.getPoint(0, 0);
+  EXPECT_FALSE(reader.canCapture(engine, point, 0));
+  EXPECT_TRUE(reader.canCapture(engine, point, 1));
+  EXPECT_TRUE(reader.canCapture(engine, point, 3));
+
+  // A chain with 4 liberties counts as safe
+  GoEngine open(9);
+  setUp(open, {"", "", "", "", "....O...."});
+  EXPECT_FALSE(reader.canCapture(open, open.getPoint(4, 4), 5));
+}
+
+TEST(TacticsTest, QueriesLeaveThePositionAlone) {
+  GoEngine engine(9);
+  setUp(engine, LADDER);
+  engine.passTurn(WHITE);
+  ASSERT_TRUE(engine.doMove(3, 2, BLACK));
+  uint64_t hash = engine.getHash();
+  Stone toMove = engine.getPlayerToMove();
+  int koPoint = engine.getKoPoint();
+  int lastMove = engine.getRecentMove(0);
+
+  TacticalReader reader;
+  for (int point : {engine.getPoint(2, 2), engine.getPoint(2, 1), engine.getPoint(3, 2)}) {
+    reader.isLadderCaptured(engine, point);
+    reader.canEscapeAtari(engine, point);
+    reader.canCapture(engine, point, 2);
+  }
+  EXPECT_GT(reader.getNodes(), 0);
+  EXPECT_EQ(engine.getHash(), hash);
+  EXPECT_EQ(engine.getPlayerToMove(), toMove);
+  EXPECT_EQ(engine.getKoPoint(), koPoint);
+  EXPECT_EQ(engine.getRecentMove(0), lastMove);
+  EXPECT_TRUE(engine.doMove(2, 3, WHITE));
+}
+
+TEST(TacticsTest, CacheAndBudget) {
+  GoEngine engine(19);
+  std::vector<std::string> rows(19, std::string(19, '.'));
+  rows[1][2] = 'X';
+  rows[2][1] = 'X';
+  rows[2][2] = 'O';
+  rows[3][1] = 'X';
+  setUp(engine, rows);
+  int point = engine.getPoint(2, 2);
+
+  TacticalReader reader;
+  EXPECT_TRUE(reader.isLadderCaptured(engine, point));
+  int64_t first = reader.getNodes();
+  EXPECT_TRUE(reader.isLadderCaptured(engine, point));
+  EXPECT_EQ(reader.getNodes(), first + 1);
+
+  reader.clear();
+  EXPECT_TRUE(reader.isLadderCaptured(engine, point));
+  EXPECT_EQ(reader.getNodes(), 2 * first + 1);
+
+  // A long ladder needs more nodes than this; running out counts as safe
+  TacticalReader small(5);
+  EXPECT_FALSE(small.isLadderCaptured(engine, point));
+  EXPECT_TRUE(small.canEscapeAtari(engine, point));
+}
+
+TEST(TacticsTest, SameAnswersForEveryEngine) {
+  std::vector<std::string> rows = {
+      "OO.X.....",
+      "..X......",
+      "XX.......",
+      ".........",
+      "......X..",
+      ".....XO..",
+      ".........",
+      ".........",
+      ".........",
+  };
+  GoEngine wrapped(9);
+  BasicGoEngine<9> fixed;
+  BasicGoEngine<0> dynamic(9);
+  setUp(wrapped, rows);
+  setUp(fixed, rows);
+  setUp(dynamic, rows);
+
+  TacticalReader reader;
+  for (int y = 0; y < 9; ++y) {
+    for (int x = 0; x < 9; ++x) {
+      int point = wrapped.getPoint(x, y);
+      for (int depth = 0; depth < 3; ++depth) {
+        bool expected = reader.canCapture(wrapped, point, depth);
+        EXPECT_EQ(reader.canCapture(fixed, point, depth), expected);
+        EXPECT_EQ(reader.canCapture(dynamic, point, depth), expected);
+      }
+      bool ladder = reader.isLadderCaptured(wrapped, point);
+      EXPECT_EQ(reader.isLadderCaptured(fixed, point), ladder);
+      EXPECT_EQ(reader.isLadderCaptured(dynamic, point), ladder);
+    }
+  }
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "go_engine.hpp"
+#include "mcts.hpp"
+#include "transposition_table.hpp"
+
+TEST(TranspositionTableTest, StoreAndProbe) {
+  TranspositionTable table(1 << 20);
+  EXPECT_LE(table.getSize(), 1u << 20);
+  EXPECT_GT(table.getSize(), 1u << 19);
+
+  PositionStats stats;
+  EXPECT_FALSE(table.probe(12345, stats));
+  table.store(12345, PositionStats{10, 6.5});
+  ASSERT_TRUE(table.probe(12345, stats));
+  EXPECT_EQ(stats.visits, 10u);
+  EXPECT_DOUBLE_EQ(stats.wins, 6.5);
+
+  table.add(12345, 2, 1);
+  ASSERT_TRUE(table.probe(12345, stats));
+  EXPECT_EQ(stats.visits, 12u);
+  EXPECT_DOUBLE_EQ(stats.wins, 7.5);
+
+  table.clear();
+  EXPECT_FALSE(table.probe(12345, stats));
+}
+
+TEST(TranspositionTableTest, ReplacesOldSearchesFirst) {
+  // A single bucket, so every key competes for the same four entries
+  TranspositionTable table(1);
+  for (uint64_t key = 1; key <= 4; ++key) {
+    table.store(key, PositionStats{100, 50});
+  }
+  table.newSearch();
+  table.store(5, PositionStats{1, 0});
+  table.store(6, PositionStats{1, 0});
+
+  // The two new entries push out two of the old ones despite fewer visits
+  PositionStats stats;
+  int old = 0;
+  for (uint64_t key = 1; key <= 4; ++key) {
+    old += table.probe(key, stats);
+  }
+  EXPECT_EQ(old, 2);
+  EXPECT_TRUE(table.probe(5, stats));
+  EXPECT_TRUE(table.probe(6, stats));
+
+  // Once the old ones are gone, the entry with the fewest visits goes
+  table.store(7, PositionStats{1000, 0});
+  table.store(8, PositionStats{1000, 0});
+  table.store(9, PositionStats{1000, 0});
+  EXPECT_TRUE(table.probe(7, stats));
+  EXPECT_TRUE(table.probe(8, stats));
+  EXPECT_TRUE(table.probe(9, stats));
+  EXPECT_EQ(table.probe(5, stats) + table.probe(6, stats), 1);
+}
+
+TEST(TranspositionTableTest, ConcurrentWritersNeverTear) {
+  TranspositionTable table(1 << 12);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&table, t] {
+      for (int i = 0; i < 200000; ++i) {
+        // Keys collide constantly; each key always carries visits == key % 1000
+        uint64_t key = (uint64_t(i) * 7919 + t) % 5000 + 1;
+        table.store(key * 0x9E3779B97F4A7C15ULL, PositionStats{uint32_t(key % 1000), 0});
+        PositionStats stats;
+        uint64_t probeKey = (uint64_t(i) * 104729) % 5000 + 1;
+        if (table.probe(probeKey * 0x9E3779B97F4A7C15ULL, stats)) {
+          ASSERT_EQ(stats.visits, probeKey % 1000);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(TranspositionTableTest, SearchSharesStatsByPosition) {
+  TranspositionTable table(16 << 20);
+  GoEngine engine(5);
+  SearchOptions options;
+  options.threads = 1; // concurrent adds may drop a count, and this test counts exactly
+  options.transpositions = &table;
+  Mcts mcts(options);
+  SearchResult result = mcts.search(engine, SearchBudget{3000, 0});
+
+  PositionStats stats;
+  ASSERT_TRUE(table.probe(engine.getHash(), stats));
+  EXPECT_EQ(stats.visits, 3000u);
+
+  int bestVisits = 0;
+  for (auto [move, visits] : result.visits) {
+    if (move == result.bestMove) {
+      bestVisits = visits;
+    }
+  }
+  auto [x, y] = engine.getCoordinates(result.bestMove);
+  ASSERT_TRUE(engine.placeStone(x, y, BLACK));
+  ASSERT_TRUE(table.probe(engine.getHash(), stats));
+  EXPECT_GE(stats.visits, uint32_t(bestVisits));
+  EXPECT_GT(table.hashfull(), 0);
+}
@@ -0,0 +1,67 @@
+// Converts every SGF file under the given directories into one game-record
+// file.
+//
+//   sgf_convert <output.gor> <directory or file>...
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "game_record.hpp"
+#include "sgf.hpp"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output.gor> <directory or file>..." << std::endl;
+        return 2;
+    }
+
+    std::vector<fs::path> files;
+    for (int i = 2; i < argc; ++i) {
+        fs::path root(argv[i]);
+        if (fs::is_directory(root)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(root)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".sgf") {
+                    files.push_back(entry.path());
+                }
+            }
+        } else {
+            files.push_back(root);
+        }
+    }
+
+    int64_t errors = 0;
+    int64_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    GameRecordWriter writer(argv[1]);
+    for (const fs::path& path : files) {
+        try {
+            MappedFile file(path.string());
+            bytes += file.contents().size();
+            convertSgf(file.contents(), writer);
+        } catch (const std::exception& error) {
+            // Games read before the error are kept
+            errors++;
+            std::cerr << path.string() << ": " << error.what() << std::endl;
+        }
+    }
+    size_t games = writer.getGameCount();
+    writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uintmax_t written = fs::file_size(argv[1]);
+    std::cout << "files: " << files.size() << std::endl;
+    std::cout << "games: " << games << std::endl;
+    std::cout << "errors: " << errors << std::endl;
+    std::cout << "SGF bytes: " << bytes << std::endl;
+    std::cout << "record bytes: " << written << std::endl;
+    std::cout << "seconds: " << seconds << std::endl;
+    if (seconds > 0) {
+        std::cout << "games/sec: " << games / seconds << std::endl;
+    }
+    return errors == 0 ? 0 : 1;
+}
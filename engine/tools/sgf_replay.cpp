@@ -0,0 +1,125 @@
+// Replays every SGF or game-record (.gor) file under a directory through
+// the engine and reports parsing and replay throughput.
+//
+//   sgf_replay <directory or file>...
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "game_record.hpp"
+#include "sgf.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Totals {
+    int64_t files = 0;
+    int64_t games = 0;
+    int64_t moves = 0;
+    int64_t illegalMoves = 0;
+    int64_t gamesWithIllegalMoves = 0;
+    int64_t errors = 0;
+    int64_t bytes = 0;
+};
+
+// game is the record's 1-based index within the file at path
+void count(const fs::path& path, int64_t game, const ReplayReport& report, Totals& totals) {
+    totals.games++;
+    totals.moves += report.moves;
+    totals.illegalMoves += report.illegalMoves.size();
+    if (!report.illegalMoves.empty()) {
+        totals.gamesWithIllegalMoves++;
+        std::cerr << path.string() << ": game " << game << " has an illegal move at move "
+                  << report.illegalMoves.front() + 1 << std::endl;
+    }
+}
+
+void replayRecords(const fs::path& path, Totals& totals) {
+    GameRecordReader reader(path.string());
+    totals.files++;
+    totals.bytes += fs::file_size(path);
+
+    for (size_t i = 0; i < reader.getGameCount(); ++i) {
+        GameRecord game = reader.getGame(i);
+        GoEngine engine(game.size);
+        count(path, i + 1, replay(game, engine), totals);
+    }
+}
+
+void replayFile(const fs::path& path, SgfGame& game, Totals& totals) {
+    MappedFile file(path.string());
+    SgfReader reader(file.contents());
+    totals.files++;
+    totals.bytes += file.contents().size();
+
+    int64_t games = 0;
+    try {
+        while (reader.next(game)) {
+            GoEngine engine(game.size);
+            count(path, ++games, replay(game, engine), totals);
+        }
+    } catch (const SgfError& error) {
+        // The rest of the file cannot be trusted; go on with the next one
+        totals.errors++;
+        std::cerr << path.string() << ": " << error.what() << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <directory or file>..." << std::endl;
+        return 2;
+    }
+
+    std::vector<fs::path> files;
+    for (int i = 1; i < argc; ++i) {
+        fs::path root(argv[i]);
+        if (fs::is_directory(root)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(root)) {
+                fs::path extension = entry.path().extension();
+                if (entry.is_regular_file() && (extension == ".sgf" || extension == ".gor")) {
+                    files.push_back(entry.path());
+                }
+            }
+        } else {
+            files.push_back(root);
+        }
+    }
+
+    Totals totals;
+    SgfGame game;
+    auto start = std::chrono::steady_clock::now();
+    for (const fs::path& path : files) {
+        try {
+            if (path.extension() == ".gor") {
+                replayRecords(path, totals);
+            } else {
+                replayFile(path, game, totals);
+            }
+        } catch (const std::exception& error) {
+            totals.errors++;
+            std::cerr << path.string() << ": " << error.what() << std::endl;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "files: " << totals.files << std::endl;
+    std::cout << "games: " << totals.games << std::endl;
+    std::cout << "moves: " << totals.moves << std::endl;
+    std::cout << "illegal moves: " << totals.illegalMoves << " in " << totals.gamesWithIllegalMoves << " games"
+              << std::endl;
+    std::cout << "errors: " << totals.errors << std::endl;
+    std::cout << "seconds: " << seconds << std::endl;
+    if (seconds > 0) {
+        std::cout << "games/sec: " << totals.games / seconds << std::endl;
+        std::cout << "moves/sec: " << totals.moves / seconds << std::endl;
+        std::cout << "MB/sec: " << totals.bytes / seconds / 1e6 << std::endl;
+    }
+    return totals.errors == 0 ? 0 : 1;
+}